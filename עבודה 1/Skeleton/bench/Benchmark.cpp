@@ -0,0 +1,199 @@
+// Microbenchmarks for the simulator's hot paths, run against a generated world.
+// Every benchmark reports nanoseconds and heap allocations per operation, and throughput in
+// the unit it works on, so a change can be compared with a run from before it.
+#include "Simulation.h"
+#include "SelectionPolicy.h"
+#include "Auxiliary.h"
+#include "WorldGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <new>
+#include <unistd.h>
+
+using namespace std;
+
+// every heap allocation in the process is counted
+static std::atomic<long long> allocations(0);
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+static string filter;
+static const double MIN_SECONDS = 0.2;
+
+// runs op in growing batches until a batch takes MIN_SECONDS, then reports that batch
+static void run(const string &name, const std::function<void()> &op, double itemsPerOp, const char *unit)
+{
+    if (!filter.empty() && name.find(filter) == string::npos)
+    {
+        return;
+    }
+    long long iterations = 1;
+    while (true)
+    {
+        long long allocationsBefore = allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; i++)
+        {
+            op();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long allocated = allocations.load() - allocationsBefore;
+        if (seconds >= MIN_SECONDS || iterations >= (1LL << 40))
+        {
+            printf("%-40s %12lld %14.1f %12.2f %14.3g %s/s\n", name.c_str(), iterations, seconds * 1e9 / iterations,
+                   static_cast<double>(allocated) / iterations, itemsPerOp * iterations / seconds, unit);
+            return;
+        }
+        iterations = seconds <= 0 ? iterations * 100 : std::max(iterations * 2, static_cast<long long>(iterations * MIN_SECONDS * 1.2 / seconds));
+    }
+}
+
+static void usage()
+{
+    cout << "usage: bench [--settlements <n>] [--facilities <n>] [--mix <life:economy:environment>] [--plans <n>] [--seed <n>]" << endl;
+    cout << "             [--filter <benchmark name part>] [--write-config <path>]" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    WorldGenerator::Options options;
+    string configOut;
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        string value = argv[++i];
+        if (option == "--settlements")
+            options.settlements = std::stoi(value);
+        else if (option == "--facilities")
+            options.facilities = std::stoi(value);
+        else if (option == "--plans")
+            options.plans = std::stoi(value);
+        else if (option == "--seed")
+            options.seed = std::stoul(value);
+        else if (option == "--filter")
+            filter = value;
+        else if (option == "--write-config")
+            configOut = value;
+        else if (option == "--mix" && sscanf(value.c_str(), "%d:%d:%d", &options.lifeQualityWeight, &options.economyWeight, &options.environmentWeight) == 3)
+            continue;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    std::ostringstream generated;
+    WorldGenerator(options).writeConfig(generated);
+    string config = generated.str();
+    string configPath = configOut;
+    if (configPath.empty())
+    {
+        char path[] = "/tmp/simulation-bench-XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+        {
+            cerr << "Cannot create a temporary config" << endl;
+            return 1;
+        }
+        close(fd);
+        configPath = path;
+    }
+    {
+        std::ofstream file(configPath);
+        file << config;
+    }
+    int configLines = std::count(config.begin(), config.end(), '\n');
+
+    printf("world: %d settlements, %d facilities (%d:%d:%d), %d plans, seed %u\n", options.settlements, options.facilities,
+           options.lifeQualityWeight, options.economyWeight, options.environmentWeight, options.plans, options.seed);
+    printf("%-40s %12s %14s %12s %16s\n", "benchmark", "ops", "ns/op", "allocs/op", "throughput");
+
+    run("Auxiliary::parseArguments", []()
+        { Auxiliary::parseArguments("facility facility42 1 5 3 2 1"); }, 1, "lines");
+
+    run("config loading", [&]()
+        { Simulation simulation(configPath); }, configLines, "lines");
+
+    Simulation world(configPath);
+    FacilityCatalog catalog = world.getCatalog();
+    NaiveSelection naive;
+    BalancedSelection balanced(0, 0, 0);
+    EconomySelection economy;
+    SustainabilitySelection sustainability;
+    run("NaiveSelection::selectFacility", [&]()
+        { naive.selectFacility(catalog); }, 1, "selections");
+    run("BalancedSelection::selectFacility", [&]()
+        { balanced.setFields(0, 0, 0);
+          balanced.selectFacility(catalog); }, catalog.size(), "candidates");
+    run("EconomySelection::selectFacility", [&]()
+        { economy.selectFacility(catalog); }, 1, "selections");
+    run("SustainabilitySelection::selectFacility", [&]()
+        { sustainability.selectFacility(catalog); }, 1, "selections");
+
+    // a separate simulation whose plans are all stepped on their own
+    {
+        Simulation independent(configPath);
+        vector<Plan *> plans;
+        for (int i = 0; i < independent.getPlanCount(); i++)
+        {
+            plans.push_back(&independent.getPlan(i));
+        }
+        PlanWorld planWorld = independent.getWorld();
+        size_t next = 0;
+        if (!plans.empty())
+        {
+            run("Plan::step", [&]()
+                { plans[next]->step(planWorld);
+                  next = next + 1 == plans.size() ? 0 : next + 1; }, 1, "plan steps");
+        }
+    }
+
+    run("Simulation::step", [&]()
+        { world.step(); }, world.getPlanCount(), "plan steps");
+    run("Simulation::step(100)", [&]()
+        { world.step(100); }, 100.0 * world.getPlanCount(), "plan steps");
+
+    run("backup (copy construct)", [&]()
+        { Simulation copy(world); }, world.getPlanCount(), "plans");
+    Simulation restored(world);
+    run("restore (copy assign)", [&]()
+        { restored = world; }, world.getPlanCount(), "plans");
+
+    if (configOut.empty())
+    {
+        unlink(configPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Replays a command trace into a simulation, as fast as possible or at a fixed rate, and reports
+// latency percentiles per command type, throughput and peak memory.
+// It can also generate a world and a trace of any length to replay against it.
+#include "Simulation.h"
+#include "Action.h"
+#include "WorldGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <streambuf>
+#include <thread>
+#include <sys/resource.h>
+
+using namespace std;
+
+extern thread_local Simulation *backup;
+
+// accepts and drops everything, so commands still pay for formatting their output
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return c == traits_type::eof() ? 0 : c;
+    }
+    std::streamsize xsputn(const char *, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+static void usage()
+{
+    cout << "usage: replay <config_path> <trace_path> [--rate <commands_per_second>]" << endl;
+    cout << "       replay --generate <config_out> <trace_out> [--commands <n>] [--settlements <n>] [--facilities <n>] [--plans <n>] [--seed <n>]" << endl;
+}
+
+static int generate(int argc, char **argv)
+{
+    WorldGenerator::Options options;
+    long long commands = 1000000;
+    for (int i = 4; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        if (option == "--commands")
+            commands = std::stoll(argv[i + 1]);
+        else if (option == "--settlements")
+            options.settlements = std::stoi(argv[i + 1]);
+        else if (option == "--facilities")
+            options.facilities = std::stoi(argv[i + 1]);
+        else if (option == "--plans")
+            options.plans = std::stoi(argv[i + 1]);
+        else if (option == "--seed")
+            options.seed = std::stoul(argv[i + 1]);
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    WorldGenerator generator(options);
+    std::ofstream config(argv[2]);
+    std::ofstream trace(argv[3]);
+    if (!config || !trace)
+    {
+        cerr << "Cannot write the generated files" << endl;
+        return 1;
+    }
+    generator.writeConfig(config);
+    generator.writeTrace(trace, commands);
+    return 0;
+}
+
+static double percentile(vector<float> &latencies, double fraction)
+{
+    size_t rank = std::min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()));
+    std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+    return latencies[rank];
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 4 && string(argv[1]) == "--generate" && argc % 2 == 0)
+    {
+        return generate(argc, argv);
+    }
+    if (argc != 3 && !(argc == 5 && string(argv[3]) == "--rate"))
+    {
+        usage();
+        return 1;
+    }
+    double rate = argc == 5 ? std::stod(argv[4]) : 0;
+    std::ifstream trace(argv[2]);
+    if (!trace)
+    {
+        cerr << "Cannot open file: " << argv[2] << endl;
+        return 1;
+    }
+
+    Simulation simulation(argv[1]);
+    DiscardBuffer discardBuffer;
+    std::ostream discard(&discardBuffer);
+    simulation.setOutput(discard);
+    simulation.open();
+
+    std::map<string, vector<float>> latencies; // microseconds, by command
+    long long commands = 0;
+    auto start = std::chrono::steady_clock::now();
+    string line;
+    while (simulation.getIsRunning() && std::getline(trace, line))
+    {
+        if (rate > 0)
+        {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(commands / rate)));
+        }
+        auto begin = std::chrono::steady_clock::now();
+        BaseAction *action = nullptr;
+        try
+        {
+            action = Simulation::parseAction(line);
+        }
+        catch (const std::exception &e)
+        {
+            action = nullptr;
+        }
+        if (action == nullptr)
+        {
+            discard << "Command not found" << endl;
+        }
+        else
+        {
+            simulation.execute(action);
+        }
+        auto end = std::chrono::steady_clock::now();
+        string command = line.substr(0, line.find(' '));
+        latencies[action == nullptr ? "(unknown)" : command].push_back(std::chrono::duration<float, std::micro>(end - begin).count());
+        commands++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-14s %10s %12s %12s %12s %12s\n", "command", "count", "p50 us", "p99 us", "p99.9 us", "max us");
+    for (auto &entry : latencies)
+    {
+        vector<float> &samples = entry.second;
+        double max = *std::max_element(samples.begin(), samples.end());
+        double p50 = percentile(samples, 0.5);
+        double p99 = percentile(samples, 0.99);
+        double p999 = percentile(samples, 0.999);
+        printf("%-14s %10zu %12.1f %12.1f %12.1f %12.1f\n", entry.first.c_str(), samples.size(), p50, p99, p999, max);
+    }
+    printf("%lld commands in %.3f s: %.0f commands/s, peak RSS %.1f MB\n", commands, seconds, commands / seconds, usage.ru_maxrss / 1024.0);
+
+    delete backup;
+    backup = nullptr;
+    return 0;
+}
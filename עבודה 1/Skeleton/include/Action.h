@@ -18,6 +18,8 @@ class BaseAction{
         virtual const string toString() const=0;
         virtual BaseAction* clone() const = 0;
         virtual ~BaseAction() = default;
+        static void *operator new(std::size_t size); // counted as action memory
+        static void operator delete(void *action);
 
     protected:
         void complete();
@@ -91,6 +93,27 @@ class PrintPlanStatus: public BaseAction {
         const int planId;
 };
 
+// What changed in one plan since the caller's cursor (see PlanCursor)
+class PrintPlanChanges : public BaseAction {
+    public:
+        PrintPlanChanges(int planId, const string &cursor);
+        void act(Simulation &simulation) override;
+        PrintPlanChanges *clone() const override;
+        const string toString() const override;
+    private:
+        const int planId;
+        const string cursor; // generation:completed:started, anything else asks for everything
+};
+
+// What changed in every plan since the last time this was asked
+class PrintChangedPlans : public BaseAction {
+    public:
+        PrintChangedPlans();
+        void act(Simulation &simulation) override;
+        PrintChangedPlans *clone() const override;
+        const string toString() const override;
+};
+
 
 class ChangePlanPolicy : public BaseAction {
     public:
@@ -104,6 +127,19 @@ class ChangePlanPolicy : public BaseAction {
 };
 
 
+// Runs a copy of the plan under every built-in policy, side by side, without touching the plan itself
+class ComparePolicies : public BaseAction {
+    public:
+        ComparePolicies(const int planId, const int numOfSteps);
+        void act(Simulation &simulation) override;
+        ComparePolicies *clone() const override;
+        const string toString() const override;
+    private:
+        const int planId;
+        const int numOfSteps;
+};
+
+
 class PrintActionsLog : public BaseAction {
     public:
         PrintActionsLog();
@@ -139,4 +175,83 @@ class RestoreSimulation : public BaseAction {
         RestoreSimulation *clone() const override;
         const string toString() const override;
     private:
-};
\ No newline at end of file
+};
+
+// Prints the hot-path counters of the whole process (see Stats.h)
+class PrintStats : public BaseAction {
+    public:
+        PrintStats(bool json);
+        void act(Simulation &simulation) override;
+        PrintStats *clone() const override;
+        const string toString() const override;
+    private:
+        const bool json;
+};
+
+// Prints where the process's memory is and how much of it (see Memory.h)
+class PrintMemory : public BaseAction {
+    public:
+        PrintMemory();
+        void act(Simulation &simulation) override;
+        PrintMemory *clone() const override;
+        const string toString() const override;
+};
+
+// Writes every plan's state to a columnar file in the background (see PlanExport.h)
+class ExportPlans : public BaseAction {
+    public:
+        ExportPlans(const string &path);
+        void act(Simulation &simulation) override;
+        ExportPlans *clone() const override;
+        const string toString() const override;
+    private:
+        const string path;
+};
+
+// The best plans by one score, from the simulation's leaderboard
+class PrintTopPlans : public BaseAction {
+    public:
+        PrintTopPlans(const string &metric, int count);
+        void act(Simulation &simulation) override;
+        PrintTopPlans *clone() const override;
+        const string toString() const override;
+    private:
+        const string metric; // life, economy, env or balance
+        const int count;
+};
+
+// A settlement's plans in total, from running sums kept by the simulation
+class PrintSettlementStatus : public BaseAction {
+    public:
+        PrintSettlementStatus(const string &settlementName);
+        void act(Simulation &simulation) override;
+        PrintSettlementStatus *clone() const override;
+        const string toString() const override;
+    private:
+        const string settlementName;
+};
+
+// Steps until a condition on the plans holds, or maxSteps ran out (see StepCondition)
+class StepUntil : public BaseAction {
+    public:
+        StepUntil(int maxSteps, const string &condition);
+        void act(Simulation &simulation) override;
+        StepUntil *clone() const override;
+        const string toString() const override;
+    private:
+        const int maxSteps;
+        const string condition;
+};
+
+// Many fresh plans at once: one settlement's or, for *, every settlement's, logged as one action
+class AddPlans : public BaseAction {
+    public:
+        AddPlans(const string &settlementName, const string &selectionPolicy, int count);
+        void act(Simulation &simulation) override;
+        AddPlans *clone() const override;
+        const string toString() const override;
+    private:
+        const string settlementName;
+        const string selectionPolicy;
+        const int count; // per settlement
+};
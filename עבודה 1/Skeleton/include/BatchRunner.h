@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "Simulation.h"
+using std::string;
+using std::vector;
+
+// Runs one command script against many configs inside a single process.
+// Simulations run on a pool of worker threads; configs that declare the same facilities share
+// one catalog, and every run contributes one JSON line to a single results file.
+class BatchRunner
+{
+public:
+    BatchRunner(const string &configsPath, const string &scriptPath, int jobs, const string &resultsPath);
+    void run();
+
+private:
+    void runJob(int index);
+    FacilityCatalog shareCatalog(const FacilityCatalog &catalog);
+
+    vector<string> configs;
+    vector<string> script;
+    const int jobs;
+    const string resultsPath;
+    vector<string> results; // one line per config, in config order
+    std::mutex catalogsLock;
+    std::map<string, FacilityCatalog> catalogs;
+};
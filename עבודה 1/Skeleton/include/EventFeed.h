@@ -0,0 +1,41 @@
+#pragma once
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "StepObserver.h"
+using std::string;
+
+// Streams the plans' events (facility started, facility completed, plan became busy) to a file
+// or FIFO, one record per event, as JSON lines or in a compact binary form.
+// Each tick's records are encoded into a batch on the simulation's thread and handed to a writer
+// thread at the end of the tick, so the tick loop never waits on the file.
+//
+// Binary form: the 8 bytes "PLANEV1\n", then per event a kind byte (PlanEventKind) followed by
+// tick, plan id, facility and the three score deltas as little-endian 32-bit integers (25 bytes).
+class EventFeed : public StepObserver
+{
+public:
+    EventFeed(const string &path, bool binary);
+    bool isOpen() const;
+    void onPlanChanged(int tick, const Plan &plan) override;
+    void onPlanEvent(const PlanEvent &event) override;
+    void onTickEnd(int tick) override;
+    ~EventFeed(); // writes out what is left
+    EventFeed(const EventFeed &other) = delete;
+    EventFeed &operator=(const EventFeed &other) = delete;
+
+private:
+    void appendInt(int value);
+    void writeLoop();
+
+    const bool binary;
+    std::ofstream file;
+    string batch;   // the current tick's records, touched by the simulation's thread only
+    string pending; // records handed over, waiting for the writer
+    std::mutex pendingLock;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread writer;
+};
@@ -47,6 +47,10 @@ public:
     const string &getSettlementName() const;
     const int getTimeLeft() const;
     FacilityStatus step();
+    // Counts down a packed array of up to 32 construction timers in place, like step() does for one
+    // facility, and returns a bitmask of the timers that reached zero.
+    // The array must have room for count rounded up to a multiple of 4.
+    static unsigned countdown(int *timeLeft, int count);
     void setStatus(FacilityStatus status);
     const FacilityStatus &getStatus() const;
     const string toString() const;
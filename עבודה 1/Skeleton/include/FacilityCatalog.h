@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "Facility.h"
+using std::string;
+
+// The part of a facility type that selection and construction read, packed into 16 bytes.
+// Prices beyond +-2^29 ticks are clamped to fit the category beside them.
+struct FacilityStats
+{
+    int price : 30;
+    unsigned category : 2;
+    int lifeQuality_score;
+    int economy_score;
+    int environment_score;
+
+    int getCost() const { return price; }
+    FacilityCategory getCategory() const { return static_cast<FacilityCategory>(category); }
+    int getLifeQualityScore() const { return lifeQuality_score; }
+    int getEconomyScore() const { return economy_score; }
+    int getEnvironmentScore() const { return environment_score; }
+};
+
+static_assert(sizeof(FacilityStats) == 16, "facility stats should stay 16 bytes");
+
+// The facilities plans can build, shared by a simulation, its backups and batch runs.
+// The stats and the names are kept in separate tables, so selection scans only touch the stats;
+// names are for printing. Entries live in chunks that double in size and never move, and each
+// new entry is published with one atomic store, so readers (parallel steppers included) never
+// lock and never see an entry half built. A FacilityCatalog is a view of the first size()
+// entries: appending to the end of the shared storage copies nothing, and only a view that has
+// fallen behind someone else's appends (a restored backup, say) takes a private copy before
+// adding its own.
+class FacilityCatalog
+{
+public:
+    FacilityCatalog();
+    int size() const;
+    const FacilityStats &operator[](int index) const;
+    const string &getName(int index) const;
+    FacilityType getType(int index) const;
+    void push_back(const FacilityType &facility);
+
+private:
+    class Storage
+    {
+    public:
+        Storage();
+        ~Storage();
+        Storage(const Storage &other) = delete;
+        Storage &operator=(const Storage &other) = delete;
+        bool append(int expectedSize, const FacilityStats &stats, const string &name); // false if the storage has grown past expectedSize
+        const FacilityStats &stats(int index) const;
+        const string &name(int index) const;
+        int published() const;
+
+    private:
+        static const int FIRST_CHUNK_SHIFT = 4; // chunk k holds 16 << k entries
+        static const int MAX_CHUNKS = 27;
+        static void locate(int index, int &chunk, int &offset);
+
+        std::atomic<FacilityStats *> statsChunks[MAX_CHUNKS];
+        std::atomic<string *> nameChunks[MAX_CHUNKS];
+        std::atomic<int> size;
+        std::mutex appendLock; // appenders only
+    };
+
+    std::shared_ptr<Storage> storage;
+    int count;
+};
+
+// selection scans call this for every candidate, keep it inline
+inline void FacilityCatalog::Storage::locate(int index, int &chunk, int &offset)
+{
+    unsigned position = static_cast<unsigned>(index) + (1u << FIRST_CHUNK_SHIFT);
+    int highBit = 31 - __builtin_clz(position);
+    chunk = highBit - FIRST_CHUNK_SHIFT;
+    offset = position - (1u << highBit);
+}
+
+inline const FacilityStats &FacilityCatalog::Storage::stats(int index) const
+{
+    int chunk;
+    int offset;
+    locate(index, chunk, offset);
+    return statsChunks[chunk].load(std::memory_order_acquire)[offset];
+}
+
+inline const FacilityStats &FacilityCatalog::operator[](int index) const
+{
+    return storage->stats(index);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+using std::vector;
+
+// The facilities the plans of one simulation have finished building, as catalog indices.
+// Each plan's list is a chain of small chunks and the plan only keeps its last chunk and its length,
+// so a finished facility costs a few bytes and copying a simulation copies one array.
+// Appending writes past the end of the list in place: when several plans hold the same list,
+// only one of them may append to it.
+class FacilityStore
+{
+public:
+    FacilityStore();
+    int append(int tail, int count, int facility);                     // returns the list's new last chunk
+    void read(int tail, int count, vector<int> &facilities) const;      // the list, in construction order
+    void readFrom(int tail, int count, int first, vector<int> &facilities) const; // its end from position first, touching only those chunks
+    int copyList(int tail, int count, FacilityStore &destination) const; // returns the copy's last chunk
+    void clear();
+    long long memoryBytes() const;
+
+    // Rule of 5
+    FacilityStore(const FacilityStore &other);            // copy constructor
+    FacilityStore &operator=(const FacilityStore &other); // copy assignment operator
+    ~FacilityStore();                                     // Destructor
+    FacilityStore(FacilityStore &&other);                 // move constructor
+    FacilityStore &operator=(FacilityStore &&other);      // move assignment operator
+
+private:
+    static const int CHUNK_SIZE = 8; // the previous chunk, then up to CHUNK_SIZE - 1 facilities
+    void account(long long bytes, long long chunkCount) const;
+    vector<int> chunks;
+};
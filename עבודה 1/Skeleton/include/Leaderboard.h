@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "Plan.h"
+using std::vector;
+
+// The best plans by each score, kept up to date as plans finish facilities instead of being
+// sorted on demand. Every metric has a tournament tree over the plan indices whose nodes hold the
+// better of their two children, so a changed score costs one walk to the root and the best K plans
+// come out of a best-first descent in O(K log N).
+// Plans that mirror a simulated one (see Simulation) score with it: only the simulated plan has a
+// leaf, and its mirrors are listed right after it, so a step of the group updates one leaf.
+class Leaderboard
+{
+public:
+    enum Metric
+    {
+        LIFE_QUALITY,
+        ECONOMY,
+        ENVIRONMENT,
+        BALANCE, // the smallest spread between a plan's highest and lowest score
+        METRIC_COUNT,
+    };
+
+    Leaderboard();
+    void addPlan(int index, int representative, const Plan &plan); // plans are added in index order
+    void setScores(int representative, const Plan &plan);          // a simulated plan's scores changed
+    void detach(int index, int representative, const Plan &plan);  // a mirror is simulated on its own from now on
+    void handOver(int representative, int successor, const Plan &plan); // the successor simulates the group's remaining mirrors
+    void top(Metric metric, int count, vector<int> &indices) const;      // best first, ties in index order of the simulated plans
+
+private:
+    bool better(Metric metric, int first, int second) const;
+    void refresh(int index); // the walk from the index's leaf to the root, for every metric
+    void grow();
+
+    int leaves;                     // a power of two, at least the number of plans
+    vector<int> values[METRIC_COUNT]; // by plan index, larger is better
+    vector<bool> simulated;          // the plan has a leaf of its own
+    vector<int> trees[METRIC_COUNT]; // node k's children are 2k and 2k + 1, leaves start at `leaves`; -1 for none
+    vector<vector<int>> mirrors;    // by simulated plan, in index order
+};
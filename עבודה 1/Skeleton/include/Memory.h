@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+// Live bytes, object counts and peaks for the simulator's memory, by what holds it, printed by the
+// memory command. The containers report their own growth and release; actions and settlements
+// are counted by their class allocators. Counters are relaxed atomics, touched only when memory
+// is actually allocated or freed, never per tick.
+// Backup is the part of the other categories held by the backup copies (one per thread that made
+// one), it is not added to the total.
+class Memory
+{
+public:
+    enum Category
+    {
+        PLANS,       // plan pools
+        FACILITIES,  // finished-facility stores, objects are chunks of facilities
+        ACTIONS,     // action objects, in logs and backups
+        SETTLEMENTS,
+        CATALOG,     // facility catalog storage, shared between the copies that use it
+        BACKUP,
+        CATEGORY_COUNT,
+    };
+
+    static void allocated(Category category, long long bytes, long long objects = 1);
+    static void released(Category category, long long bytes, long long objects = 1);
+    static void setBackup(long long bytes); // the calling thread's backup was replaced by one of this size
+    static long long backupBytes();         // the calling thread's backup
+    static long long liveBytes();           // every category but backup
+    static long long liveBytes(Category category);
+    static long long averageObjectBytes(Category category);
+
+    static void setSoftLimit(long long bytes); // 0 for none
+    static bool wouldExceedSoftLimit(long long extraBytes = 0);
+    static void print(std::ostream &out);
+};
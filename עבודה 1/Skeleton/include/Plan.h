@@ -1,51 +1,144 @@
 #pragma once
 #include <vector>
+#include <string>
 #include "Facility.h"
 #include "Settlement.h"
 #include "SelectionPolicy.h"
+#include "FacilityStore.h"
+#include "Stats.h"
+using std::string;
 using std::vector;
 
-enum class PlanStatus
+enum class PlanStatus : unsigned char
 {
     AVALIABLE,
     BUSY,
 };
 
+enum class PlanEventKind : unsigned char
+{
+    FACILITY_STARTED,
+    FACILITY_COMPLETED,
+    PLAN_BUSY, // the plan went from AVALIABLE to BUSY
+};
+
+// One change of a plan's state during a tick
+struct PlanEvent
+{
+    PlanEventKind kind;
+    int tick;
+    int planId;
+    int facility; // catalog index, -1 for PLAN_BUSY
+    int lifeQualityDelta, economyDelta, environmentDelta; // what the change did to the plan's scores
+};
+
+// How much of a plan a reader has seen. A plan's facilities only ever grow, so the number finished
+// and the number ever started version it: any step that changes the plan raises one of them.
+// The generation changes when a restore rewinds the simulation, and makes older cursors useless.
+struct PlanCursor
+{
+    int generation;
+    int completed;
+    int started;
+};
+
+// The plans changed since the list was last drained. A plan is listed once however many ticks
+// changed it, so a long step holds at most one entry per plan.
+class ChangedPlans
+{
+public:
+    ChangedPlans() : ids(), listed() {}
+    void note(int planId)
+    {
+        if (planId >= static_cast<int>(listed.size()))
+        {
+            listed.resize(planId + 1, false);
+        }
+        if (!listed[planId])
+        {
+            listed[planId] = true;
+            ids.push_back(planId);
+        }
+    }
+    const vector<int> &list() const { return ids; }
+    void clear()
+    {
+        for (int id : ids)
+        {
+            listed[id] = false;
+        }
+        ids.clear();
+    }
+
+private:
+    vector<int> ids;
+    vector<bool> listed; // by plan id
+};
+
+// What the plans of one simulation share. A plan holds indices into it instead of pointers,
+// which keeps it within one cache line and lets a copied simulation take its plans over unchanged.
+struct PlanWorld
+{
+    const vector<Settlement *> *settlements;
+    const FacilityCatalog *facilityOptions;
+    FacilityStore *facilities; // the finished facilities of every plan
+    Stats::Block *stats;       // the stepping thread's counters
+    vector<PlanEvent> *events; // where stepping plans report their changes, nullptr when nobody listens
+    ChangedPlans *changed;     // the plans that started or finished facilities, nullptr when nobody keeps track
+};
+
 class Plan
 {
 public:
-    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
-    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, PlanStatus status, vector<Facility *> newFacilities, vector<Facility *> newUnderConstruction, const vector<FacilityType> &facilityOptions, int life_quality_score, int economy_score, int environment_score);
+    Plan(); // an empty plan, for pools to fill
+    Plan(const int planId, int settlementIndex, const Settlement &settlement, SelectionPolicy *selectionPolicy);
+    Plan(const int planId, int settlementIndex, const Settlement &settlement, SelectionPolicyKind policy); // with the policy's starting state
     const int getID() const;
     const int getlifeQualityScore() const;
     const int getEconomyScore() const;
     const int getEnvironmentScore() const;
     const PlanStatus getStatus() const;
-    void setSelectionPolicy(SelectionPolicy *selectionPolicy);
-    void step();
+    void setSelectionPolicy(SelectionPolicy *selectionPolicy); // takes the policy's state over and deletes it
+    SelectionPolicyKind getPolicyKind() const;
+    const string getSelectionPolicyName() const; // as the policy's toString
+    void step(PlanWorld &world);
     void printStatus();
-    const vector<Facility *> &getFacilities() const;
-    const vector<Facility *> &getunderConstruction() const;
-    void addFacility(Facility *facility);
-    const string toString() const;
-    const Settlement getSettlement() const;
-    const SelectionPolicy *getSelectionPolicy() const;
-    // Rule of 5
-    Plan(const Plan &other);            // copy constructor
-    Plan &operator=(const Plan &other); // copy assignment operator
-    ~Plan();                            // Destructor
-    Plan(Plan &&other);                 // move constructor
-    Plan &operator=(Plan &&other);      // move assignment operator
-    void clear();
-    void copy(const Plan &other);
+    int getSettlementIndex() const;
+    const Settlement &getSettlement(const PlanWorld &world) const;
+    vector<int> getFacilities(const PlanWorld &world) const; // finished facilities, as catalog indices
+    void readFacilities(const PlanWorld &world, vector<int> &facilities) const; // the same, into a reused vector
+    void readFacilitiesSince(const PlanWorld &world, int first, vector<int> &facilities) const; // those finished after the first ones
+    PlanCursor getCursor(int generation) const;
+    int getFacilitiesCount() const;
+    int getUnderConstruction(int slot) const; // catalog index of a facility being built
+    int getUnderConstructionCount() const;
+    const string toString(const PlanWorld &world) const;
+    void mirror(const Plan &representative);                    // take over the state of an identical plan simulated in this one's place
+    void copyFacilities(const PlanWorld &from, PlanWorld &to); // stop sharing the finished facilities, keep a private copy in to
+
+    // no settlement builds more than this many facilities at once
+    static const int MAX_UNDER_CONSTRUCTION = 3;
 
 private:
+    template <bool Traced>
+    void advance(PlanWorld &world);
+    template <int Capacity, bool Traced> // Traced: record the phases when a trace is on
+    void stepWithCapacity(PlanWorld &world);
+    int selectFacility(const FacilityCatalog &facilityOptions, Stats::Block &stats);
+
+    // Plans own no memory of their own, so the default copy and move are exact.
     int plan_id;
-    const Settlement &settlement;
-    SelectionPolicy *selectionPolicy; // What happens if we change this to a reference?
+    int settlementIndex;
+    int lastSelectedIndex; // the selection policy's state (balanced selection derives its state from the scores)
     PlanStatus status;
-    vector<Facility *> facilities;
-    vector<Facility *> underConstruction;
-    const vector<FacilityType> &facilityOptions;
+    SelectionPolicyKind policy;
+    unsigned char capacity; // the settlement's, so stepping never looks the settlement up
+    unsigned char underConstructionCount;
+    alignas(16) int constructionTimers[4];               // time left for each underConstruction entry, counted down together
+    int underConstruction[MAX_UNDER_CONSTRUCTION];       // catalog indices, in the order construction started
     int life_quality_score, economy_score, environment_score;
-};
\ No newline at end of file
+    int facilitiesTail;  // last chunk of the finished facilities in the world's store
+    int facilitiesCount;
+};
+
+static_assert(sizeof(Plan) <= 64, "a plan should fit in one cache line");
@@ -0,0 +1,52 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Simulation.h"
+using std::string;
+using std::vector;
+
+// Writes the state of every plan as a columnar file that tools can mmap and scan column by column.
+// The columns are copied out of the simulation at once, which is the consistent snapshot, and a
+// background thread encodes and writes them while the simulation goes on. A write that fails is
+// reported by the first export command after it is known, or when the run ends.
+//
+// Layout, little-endian: the 8 bytes "PLANCOL1", uint32 version (1), uint32 column count, uint64 rows,
+// int64 tick, then one 48-byte directory entry per column: char name[24] (NUL padded), uint32 type,
+// uint32 dictionary (index of the column holding this one's strings, or 0xffffffff), uint64 offset
+// and uint64 bytes. Every column starts 8-byte aligned.
+// Types: 1 int32 per row, 2 uint8 per row, 3 dictionary: uint32 count, uint32 offsets[count + 1]
+// into the characters that follow; string i runs from offsets[i] to offsets[i + 1].
+class PlanExport
+{
+public:
+    enum ColumnType
+    {
+        INT32 = 1,
+        UINT8 = 2,
+        DICTIONARY = 3,
+    };
+
+    static bool start(Simulation &simulation, const string &path); // false if the file cannot be created
+    static void waitAll();                                          // until every started export is written
+    static bool takeFailure(string &path);                          // an export whose write failed, each reported once
+
+private:
+    struct Snapshot
+    {
+        Snapshot() : tick(0), planIds(), settlements(), policies(), lifeQualityScores(), economyScores(), environmentScores(), statuses(), operational(), inProgress(), settlementNames() {}
+        long long tick;
+        vector<int> planIds;
+        vector<int> settlements; // settlement ids, codes into settlementNames
+        vector<unsigned char> policies;
+        vector<int> lifeQualityScores;
+        vector<int> economyScores;
+        vector<int> environmentScores;
+        vector<unsigned char> statuses;
+        vector<int> operational;
+        vector<unsigned char> inProgress;
+        vector<string> settlementNames;
+    };
+
+    static bool write(std::ofstream &file, const Snapshot &snapshot); // false if the file could not be written
+};
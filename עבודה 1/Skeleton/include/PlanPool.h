@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include "Plan.h"
+using std::vector;
+
+// The plans of a simulation, in fixed-size chunks: growing never moves or copies the plans
+// already there, so references to them stay valid for the life of the pool.
+class PlanPool
+{
+public:
+    PlanPool();
+    void push_back(const Plan &plan);
+    void reserve(int plans); // allocate the chunks for this many plans up front
+    Plan &operator[](int index);
+    const Plan &operator[](int index) const;
+    int size() const;
+    long long memoryBytes() const;
+
+    // Rule of 5
+    PlanPool(const PlanPool &other);            // copy constructor
+    PlanPool &operator=(const PlanPool &other); // copy assignment operator
+    ~PlanPool();                                // Destructor
+    PlanPool(PlanPool &&other);                 // move constructor
+    PlanPool &operator=(PlanPool &&other);      // move assignment operator
+    void clear();
+    void copy(const PlanPool &other);
+
+private:
+    static const int CHUNK_SHIFT = 10;
+    static const int CHUNK_PLANS = 1 << CHUNK_SHIFT; // 64KB of plans per chunk
+
+    vector<Plan *> chunks;
+    int count;
+};
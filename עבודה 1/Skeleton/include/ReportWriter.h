@@ -0,0 +1,55 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Plan.h"
+using std::string;
+using std::vector;
+
+// Formats plan reports into one reused buffer and hands the stream large blocks, so a report
+// of a whole world costs a few writes instead of a flush per line. Numbers are formatted by hand
+// and the lines that only depend on a name are built once per settlement or facility type.
+// The output is the same, byte for byte, as the stream operators would give.
+class ReportWriter
+{
+public:
+    ReportWriter();                           // collects the report, see take
+    explicit ReportWriter(std::ostream &out); // writes the report to out, at the latest when destroyed
+    ~ReportWriter();
+    ReportWriter(const ReportWriter &other) = delete;
+    ReportWriter &operator=(const ReportWriter &other) = delete;
+
+    void planSummary(const Plan &plan, const PlanWorld &world); // as close prints it
+    void planStatus(const Plan &plan, const PlanWorld &world);  // as Plan::toString describes it
+    // What changed in a plan since the reader's cursor, and the cursor to pass next time: nothing more
+    // when the plan has not changed, otherwise its state, the scores if facilities were finished,
+    // the newly finished facilities and those under construction. A cursor of an older generation gets it all.
+    void planChanges(const Plan &plan, const PlanWorld &world, const PlanCursor &seen, const PlanCursor &now);
+    void endReport(); // the blank line after a status
+    void flush();
+    string take(); // what was collected, for a writer with no stream
+
+private:
+    static const size_t FLUSH_BYTES = 1 << 16;
+
+    void append(const char *text, size_t length);
+    template <size_t N>
+    void append(const char (&text)[N])
+    {
+        append(text, N - 1);
+    }
+    void append(const string &text);
+    void appendInt(int value);
+    void appendState(const Plan &plan);
+    void appendScores(const Plan &plan);
+    void appendFacilities(const Plan &plan, const PlanWorld &world, int firstCompleted); // finished from firstCompleted on, then those being built
+    void settlementFragment(const PlanWorld &world, int settlementIndex);
+    void facilityFragment(const PlanWorld &world, int facility, bool operational);
+    void maybeFlush();
+
+    std::ostream *out;
+    string buffer;
+    vector<int> facilities; // the plan being described's finished facilities
+    vector<string> settlementFragments; // the summary's settlement line by settlement index, empty until first used
+    vector<string> facilityFragments;   // name and status lines, at 2 * catalog index when operational and one after when not
+};
@@ -1,12 +1,24 @@
 #pragma once
 #include <vector>
 #include "Facility.h"
+#include "FacilityCatalog.h"
 using std::vector;
 
+enum class SelectionPolicyKind : unsigned char
+{
+    NAIVE,
+    BALANCED,
+    ECONOMY,
+    SUSTAINABILITY,
+};
+
+// Each policy's choice is also available as a static function over explicit state, so plans can keep
+// that state inline instead of owning a policy object.
 class SelectionPolicy
 {
 public:
-    virtual const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) = 0;
+    virtual FacilityType selectFacility(const FacilityCatalog &facilitiesOptions) = 0;
+    virtual SelectionPolicyKind getKind() const = 0;
     virtual const string toString() const = 0;
     virtual SelectionPolicy *clone() const = 0;
     virtual ~SelectionPolicy() = default;
@@ -17,7 +29,10 @@ class NaiveSelection : public SelectionPolicy
 public:
     NaiveSelection();
     NaiveSelection(const int index);
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    FacilityType selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    static int select(const FacilityCatalog &facilitiesOptions, int &lastSelectedIndex); // index of the choice
+    SelectionPolicyKind getKind() const override;
+    int getLastSelectedIndex() const;
     const string toString() const override;
     NaiveSelection *clone() const override;
     ~NaiveSelection() override = default;
@@ -30,7 +45,9 @@ class BalancedSelection : public SelectionPolicy
 {
 public:
     BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    FacilityType selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    static int select(const FacilityCatalog &facilitiesOptions, int &LifeQualityScore, int &EconomyScore, int &EnvironmentScore);
+    SelectionPolicyKind getKind() const override;
     const string toString() const override;
     BalancedSelection *clone() const override;
     ~BalancedSelection() override = default;
@@ -47,7 +64,10 @@ class EconomySelection : public SelectionPolicy
 public:
     EconomySelection();
     EconomySelection(const int index);
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    FacilityType selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    static int select(const FacilityCatalog &facilitiesOptions, int &lastSelectedIndex); // index of the choice
+    SelectionPolicyKind getKind() const override;
+    int getLastSelectedIndex() const;
     const string toString() const override;
     EconomySelection *clone() const override;
     ~EconomySelection() override = default;
@@ -61,7 +81,10 @@ class SustainabilitySelection : public SelectionPolicy
 public:
     SustainabilitySelection();
     SustainabilitySelection(const int index);
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    FacilityType selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    static int select(const FacilityCatalog &facilitiesOptions, int &lastSelectedIndex); // index of the choice
+    SelectionPolicyKind getKind() const override;
+    int getLastSelectedIndex() const;
     const string toString() const override;
     SustainabilitySelection *clone() const override;
     ~SustainabilitySelection() override = default;
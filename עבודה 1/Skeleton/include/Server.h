@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include "Simulation.h"
+using std::string;
+using std::vector;
+
+// Serves one Simulation to several local clients over a Unix domain socket.
+// Every wake-up of the event loop is one tick: the complete command lines received from all
+// ready connections are run as one batch, in arrival order, and each response is queued
+// back on the connection that sent the command.
+// Queries are not served concurrently: every command, read-only or not, runs on the loop's thread
+// within the batch, since actions print through the simulation's one output stream and reading a
+// plan can still update it (a lagging or mirroring plan is brought up to date first).
+class Server
+{
+public:
+    Server(Simulation &simulation, const string &socketPath);
+    void run();
+    ~Server();
+    Server(const Server &other) = delete;
+    Server &operator=(const Server &other) = delete;
+
+private:
+    struct Connection
+    {
+        Connection() : in(), out(), closing(false) {}
+        string in;    // bytes received but not yet a full line
+        string out;   // responses not yet written
+        bool closing; // the client hung up, close once its responses are out
+    };
+    struct Command
+    {
+        int fd;
+        string line;
+    };
+
+    void open();
+    void acceptClients();
+    void readClient(int fd, vector<Command> &batch);
+    bool flushClient(int fd);
+    void closeClient(int fd);
+    void runBatch(const vector<Command> &batch);
+
+    Simulation &simulation;
+    const string socketPath;
+    int listenFd;
+    int epollFd;
+    std::map<int, Connection> connections;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <cstddef>
 using std::string;
 using std::vector;
 
@@ -22,6 +23,8 @@ public:
     const string toString() const;
     int facilitiesNum() const;
     Settlement clone() const;
+    static void *operator new(std::size_t size); // counted as settlement memory
+    static void operator delete(void *settlement, std::size_t size);
 
 private:
     const string name;
@@ -0,0 +1,41 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "Plan.h"
+using std::vector;
+
+// Running totals of the plans of every settlement, so asking about a settlement costs the same
+// however many plans it has. A simulated plan that changes moves the totals by its change, once
+// for every plan in its group (see Simulation: mirrors follow a simulated plan, possibly of another
+// settlement of the same type), so each group keeps how many of its plans each settlement has.
+class SettlementAggregates
+{
+public:
+    struct Totals
+    {
+        int plans;
+        long long lifeQualityScore, economyScore, environmentScore;
+        long long operational;       // facilities finished
+        long long underConstruction; // facilities being built
+    };
+
+    SettlementAggregates();
+    void addPlan(int index, int representative, int settlement, const Plan &plan); // plans are added in index order
+    void update(int representative, const Plan &plan);                             // a simulated plan changed
+    void detach(int index, int representative, int settlement, const Plan &plan);  // a mirror is simulated on its own from now on
+    void handOver(int representative, int settlement, int successor);               // the successor simulates the group's remaining mirrors
+    const Totals &get(int settlement);
+
+private:
+    struct State // what a simulated plan last added to the totals of each plan in its group
+    {
+        int life, eco, env, operational, underConstruction;
+    };
+    static State stateOf(const Plan &plan);
+    Totals &totalsOf(int settlement);
+    void add(int settlement, const State &state, int times);
+
+    vector<Totals> totals;                            // by settlement index
+    vector<State> states;                             // by simulated plan index
+    vector<vector<std::pair<int, int>>> groups;       // by simulated plan index: settlement and plan count
+};
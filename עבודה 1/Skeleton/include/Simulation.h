@@ -1,33 +1,96 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <ostream>
+#include <unordered_map>
 #include "Facility.h"
 #include "Plan.h"
+#include "PlanPool.h"
+#include "FacilityStore.h"
+#include "FacilityCatalog.h"
 #include "Settlement.h"
+#include "StepObserver.h"
+#include "Leaderboard.h"
+#include "SettlementAggregates.h"
+#include <memory>
 using std::string;
 using std::vector;
 
 class BaseAction;
 class SelectionPolicy;
+class StepCondition;
+class Simulation;
+
+// Walks the plans of a simulation in creation order without copying them
+class PlanIterator
+{
+public:
+    PlanIterator(Simulation &simulation, int index);
+    const Plan &operator*() const;
+    const Plan *operator->() const;
+    PlanIterator &operator++();
+    bool operator!=(const PlanIterator &other) const;
+
+private:
+    Simulation *simulation;
+    int index;
+};
+
+class PlanRange
+{
+public:
+    PlanRange(Simulation &simulation);
+    PlanIterator begin() const;
+    PlanIterator end() const;
+
+private:
+    Simulation *simulation;
+};
 
 class Simulation
 {
 public:
+    Simulation(); // an empty world, for embedding without a config file
     Simulation(const string &configFilePath);
     void start();
+    static BaseAction *parseAction(const string &command); // nullptr if the command is unknown
+    void execute(BaseAction *action);                      // act and log
     void addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy);
+    void addPlans(const string &settlementName, SelectionPolicyKind policy, int count); // count plans on the settlement, or on each one for *
+    long long bulkPlanCount(const string &settlementName, int count); // what addPlans would create, -1 if it cannot
     void addAction(BaseAction *action);
     bool addSettlement(Settlement *settlement);
     bool addFacility(FacilityType facility);
+    FacilityCatalog getCatalog() const;
+    void setCatalog(const FacilityCatalog &catalog); // adopt an identical, possibly shared, catalog
     bool isSettlementExists(const string &settlementName);
     Settlement &getSettlement(const string &settlementName);
-    Plan &getPlan(const int planID);
+    Plan &getPlan(const int planID);             // for changing a plan
+    const Plan &readPlan(const int planID);      // for looking at a plan
     void step();
+    void step(int numOfSteps);
+    bool stepUntil(int maxSteps, StepCondition &condition); // whether the condition held before maxSteps ran out
+    int getTick() const;
+    void setLazy(bool isLazy); // plans only step when someone looks at or changes them
+    void addObserver(StepObserver *observer); // not owned
+    void removeObserver(StepObserver *observer);
+    int getPlanCount() const;
+    const Plan &planAt(int index);
+    PlanRange planStates();
+    int getGeneration() const;               // changes whenever a restore rewinds the plans
+    PlanCursor &reportedCursor(int index);   // what planStatus all --changed last showed of a plan
+    const Leaderboard &getLeaderboard();     // kept up to date from its first use on
+    const SettlementAggregates::Totals &getSettlementTotals(const string &settlementName); // likewise
     void close();
     void open();
     vector<BaseAction *> getActionsLog();
     void SetIsRunning(bool isRun);
-    vector<Plan> getPlans();
+    bool getIsRunning() const;
+    std::ostream &getOutput();
+    void setOutput(std::ostream &newOutput);
+    PlanWorld getWorld(); // what a plan needs to be stepped or described, valid until the simulation changes
+    long long memoryFootprint() const; // bytes a copy would take, the shared catalog aside
+    static long long planFootprint(long long count); // bytes that many more plans add to it
 
     // Rule of 5
     Simulation(const Simulation &other);            // copy constructor
@@ -39,10 +102,37 @@ public:
     void copy(const Simulation &other);
 
 private:
+    int planIndex(const int planID) const;
+    void appendPlan(const Plan &plan); // its id is the plan count so far
+    void catchUp(int index);
+    void catchUpAll();
+    void syncPlan(int index);
+    void detachPlan(int index);
+    PlanWorld steppingWorld(); // the world, plus where to note changed plans when something keeps track of them
+    void updateIndexes();      // the leaderboard, settlement totals and stepUntil condition, for the plans noted since
+    void buildSettlementTotals();
+
     bool isRunning;
+    std::ostream *output; // where actions print, not owned (stdout unless redirected)
     int planCounter; // For assigning unique plan IDs
+    int tick;        // steps simulated so far
+    int generation;  // restores so far, see PlanCursor
+    bool lazy;       // steps only advance the tick, plans catch up when they are used
+    vector<StepObserver *> observers;
     vector<BaseAction *> actionsLog;
-    vector<Plan> plans;
+    PlanPool plans;
+    // Plans created in the same tick on the same settlement type with the same policy step identically,
+    // so only the first of them is simulated and the others mirror it until something sets them apart.
+    vector<int> representatives; // index of the plan simulated in this one's place (its own index if none)
+    vector<int> syncedTicks;     // tick at which a mirroring plan last copied its representative
+    vector<int> planTicks;       // tick a simulated plan has been stepped up to
+    std::unordered_map<string, int> freshPlans; // plans created since the last step, by state
     vector<Settlement *> settlements;
-    vector<FacilityType> facilitiesOptions;
+    FacilityCatalog facilitiesOptions; // storage shared with backups and batch runs
+    FacilityStore completedFacilities;                       // what the plans have finished building
+    vector<PlanCursor> reportedCursors;                      // by plan index, grown as plans are reported
+    std::unique_ptr<Leaderboard> leaderboard;                // built by the first top command
+    std::unique_ptr<SettlementAggregates> settlementTotals;  // built by the first settlementStatus command
+    ChangedPlans changedPlans;                               // plans stepped since the indexes were last updated
+    StepCondition *until;                                    // what a running stepUntil waits for, not owned
 };
\ No newline at end of file
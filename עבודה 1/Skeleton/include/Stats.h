@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <ostream>
+
+class BaseAction;
+
+// Counters and timers for the simulator's hot paths, printed by the stats command.
+// Every thread counts into a block of its own with relaxed loads and stores, which cost as much
+// as ordinary increments; reading the stats sums the blocks of all threads, finished ones included.
+// The tick loop reaches its block through PlanWorld, so it never looks a thread_local up per plan.
+class Stats
+{
+public:
+    enum Counter
+    {
+        TICKS,
+        PLAN_STEPS,
+        FACILITIES_STARTED,
+        FACILITIES_COMPLETED,
+        SELECTIONS,                      // one per policy kind, in SelectionPolicyKind order
+        CATALOG_SCANNED = SELECTIONS + 4, // catalog entries examined by the selections
+        COUNTER_COUNT,
+    };
+    static const int ACTION_KINDS = 21;
+    static const int HISTOGRAM_BUCKETS = 32; // bucket k counts steps of [2^k, 2^(k+1)) nanoseconds
+    static const int STEP_SAMPLE_RATE = 64;  // one plan step in this many is timed
+
+    class Block
+    {
+    public:
+        Block();
+        void add(Counter counter, long long amount = 1)
+        {
+            counters[counter].store(counters[counter].load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+        bool sampleStep()
+        {
+            if (--untilSample > 0)
+            {
+                return false;
+            }
+            untilSample = STEP_SAMPLE_RATE;
+            return true;
+        }
+        void recordStep(long long nanos);
+        void recordAction(int kind, long long nanos);
+        void foldInto(Block &total) const; // for a finishing thread
+
+    private:
+        friend class Stats;
+        std::atomic<long long> counters[COUNTER_COUNT];
+        std::atomic<long long> actionCounts[ACTION_KINDS];
+        std::atomic<long long> actionNanos[ACTION_KINDS];
+        std::atomic<long long> stepHistogram[HISTOGRAM_BUCKETS];
+        int untilSample;
+    };
+
+    static Block &local(); // the calling thread's block
+    static void recordAction(const BaseAction &action, long long nanos);
+    static const char *actionName(const BaseAction &action); // the kind the stats count it under
+    static void print(std::ostream &out, bool json);
+
+private:
+    static void sumInto(const Block &block, long long *totals);
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Plan.h"
+using std::string;
+using std::vector;
+
+// What stepUntil waits for, compiled once from its text:
+//   plan <id> <test>, any plan <test> or all plans <test>
+// where a test is <life|economy|env|balance> <op> <number> (op one of >= > <= < == !=) or a plan
+// status (AVALIABLE, BUSY); balance is the spread between a plan's highest and lowest score.
+// The condition remembers which plans pass, so after every tick it only looks at the plans that
+// changed in it.
+class StepCondition
+{
+public:
+    enum Scope
+    {
+        ONE_PLAN,
+        ANY_PLAN,
+        ALL_PLANS,
+    };
+
+    StepCondition();
+    bool compile(const string &text); // false if the text is not a condition
+    Scope getScope() const;
+    int getPlanId() const;                    // the plan a ONE_PLAN condition is about
+    void reset(int watched);                  // forget every plan; a ONE_PLAN condition only listens to watched
+    void update(int index, const Plan &plan); // a simulated plan is new or changed
+    bool holds() const;
+
+private:
+    enum Test
+    {
+        LIFE_QUALITY,
+        ECONOMY,
+        ENVIRONMENT,
+        BALANCE, // highest score minus lowest
+        STATUS,
+    };
+    enum Comparison
+    {
+        AT_LEAST,
+        ABOVE,
+        AT_MOST,
+        BELOW,
+        EQUAL,
+        NOT_EQUAL,
+    };
+    bool passes(const Plan &plan) const;
+
+    Scope scope;
+    int planId;
+    Test test;
+    Comparison comparison;
+    int value;         // what the score is compared with
+    PlanStatus status; // what a STATUS test asks for
+    int watched;
+    vector<signed char> passing; // by simulated plan index: -1 unseen, else whether it passes
+    int seen;
+    int passed;
+};
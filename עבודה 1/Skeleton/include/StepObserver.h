@@ -0,0 +1,15 @@
+#pragma once
+#include "Plan.h"
+
+// Receives the plans whose scores changed during a simulation tick.
+// The plan is a view into the simulation's own storage: it is only valid during the call.
+// Observers that want the finer changes also get every plan's events, after the plans changed
+// in the tick, and then the end of the tick.
+class StepObserver
+{
+public:
+    virtual void onPlanChanged(int tick, const Plan &plan) = 0;
+    virtual void onPlanEvent(const PlanEvent &event) {}
+    virtual void onTickEnd(int tick) {}
+    virtual ~StepObserver() = default;
+};
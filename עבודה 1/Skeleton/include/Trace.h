@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <string>
+using std::string;
+
+// Optional timeline of what the simulator spends its time on, in Chrome trace-event format
+// (load the file in Perfetto or chrome://tracing). Spans go into a ring of the recording thread's
+// own, written by that thread alone, and a background writer drains the rings into the file, so
+// recording never takes a lock or touches the file. A finished thread's ring is reused by the next
+// thread to record. When a ring is full its spans are dropped and counted. Until start is called a
+// span costs one relaxed load.
+class Trace
+{
+public:
+    static bool start(const string &path); // false if the file cannot be opened
+    static void stop();                    // drains the rings and finishes the file
+    static bool enabled()
+    {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // Records the time between its construction and destruction. The name (and argument name)
+    // must outlive the trace; a span with no name records nothing.
+    class Span
+    {
+    public:
+        explicit Span(const char *name, const char *argName = nullptr, long long arg = 0)
+            : name(name != nullptr && enabled() ? name : nullptr), argName(argName), arg(arg), startNanos(this->name != nullptr ? now() : 0)
+        {
+        }
+        ~Span()
+        {
+            if (name != nullptr)
+            {
+                record(name, argName, arg, startNanos, now());
+            }
+        }
+        Span(const Span &other) = delete;
+        Span &operator=(const Span &other) = delete;
+
+    private:
+        const char *name;
+        const char *argName;
+        long long arg;
+        long long startNanos;
+    };
+
+private:
+    static long long now(); // nanoseconds since the trace started
+    static void record(const char *name, const char *argName, long long arg, long long startNanos, long long endNanos);
+    static std::atomic<bool> active;
+};
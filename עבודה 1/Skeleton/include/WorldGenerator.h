@@ -0,0 +1,34 @@
+#pragma once
+#include <ostream>
+#include <string>
+using std::string;
+
+// Builds synthetic worlds, and command traces against them, for benchmarks and load tests.
+// The same options always give the same output, byte for byte, on every platform.
+class WorldGenerator
+{
+public:
+    struct Options
+    {
+        Options();
+        int settlements;
+        int facilities; // the first three are one of each category, so every policy finds a match
+        int lifeQualityWeight, economyWeight, environmentWeight; // category mix of the other facilities
+        int plans;
+        unsigned seed;
+    };
+
+    WorldGenerator(const Options &options);
+    void writeConfig(std::ostream &out);
+    void writeTrace(std::ostream &out, long long commands); // for the config just written, ends with close
+    static string settlementName(int index);
+    static string facilityName(int index);
+    static const char *policyName(int index); // nve, bal, eco, env
+
+private:
+    unsigned next();
+    int nextInt(int bound); // in [0, bound)
+
+    const Options options;
+    unsigned state;
+};
@@ -4,11 +4,20 @@
 #include "Facility.h"
 #include "Settlement.h"
 #include "SelectionPolicy.h"
+#include "Stats.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "ReportWriter.h"
+#include "StepCondition.h"
+#include "PlanExport.h"
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <thread>
+#include <cstdio>
+#include <cstddef>
 
-extern Simulation *backup;
+extern thread_local Simulation *backup;
 
 using namespace std;
 
@@ -60,6 +69,28 @@ BaseAction::BaseAction() : errorMsg(""), status(ActionStatus::COMPLETED)
 {
 }
 
+// an action's size is kept just before it, so delete needs no size and always matches new
+static const std::size_t ACTION_HEADER = alignof(std::max_align_t);
+
+void *BaseAction::operator new(std::size_t size)
+{
+    char *block = static_cast<char *>(::operator new(ACTION_HEADER + size));
+    *reinterpret_cast<std::size_t *>(block) = size;
+    Memory::allocated(Memory::ACTIONS, size);
+    return block + ACTION_HEADER;
+}
+
+void BaseAction::operator delete(void *action)
+{
+    if (action == nullptr)
+    {
+        return;
+    }
+    char *block = static_cast<char *>(action) - ACTION_HEADER;
+    Memory::released(Memory::ACTIONS, *reinterpret_cast<std::size_t *>(block));
+    ::operator delete(block);
+}
+
 ActionStatus BaseAction::getStatus() const
 {
     return status;
@@ -91,10 +122,7 @@ SimulateStep::SimulateStep(const int numOfSteps) : numOfSteps(numOfSteps)
 
 void SimulateStep::act(Simulation &simulation)
 {
-    for (int i = 0; i < numOfSteps; i++)
-    {
-        simulation.step();
-    }
+    simulation.step(numOfSteps);
 
     complete();
 }
@@ -124,7 +152,7 @@ void AddSettlement::act(Simulation &simulation)
     if (simulation.isSettlementExists(settlementName))
     {
         error("Settlement alreadt exists");
-        cout << getErrorMsg() << endl;
+        simulation.getOutput() << getErrorMsg() << endl;
     }
     else
     {
@@ -157,7 +185,7 @@ void AddFacility::act(Simulation &simulation)
     if (!simulation.addFacility(newFacility))
     {
         error("Facility already exists");
-        cout << getErrorMsg() << endl;
+        simulation.getOutput() << getErrorMsg() << endl;
     }
     else
     {
@@ -188,6 +216,7 @@ void ChangePlanPolicy::act(Simulation &simulation)
 
     try
     {
+        string st = simulation.readPlan(planId).getSelectionPolicyName(); // throws before a policy is made
         SelectionPolicy *sp = nullptr;
         if (newPolicy == "nve")
         {
@@ -206,26 +235,26 @@ void ChangePlanPolicy::act(Simulation &simulation)
             sp = new SustainabilitySelection();
         }
 
-        string st = simulation.getPlan(planId).getSelectionPolicy()->toString();
-        if (sp->toString() == st)
+        if (sp == nullptr || sp->toString() == st) // no such policy, or the plan already has it
         {
             error("Cannot change selection policy");
-            cout << getErrorMsg() << endl;
+            simulation.getOutput() << getErrorMsg() << endl;
             delete sp;
         }
         else
         {
-            simulation.getPlan(planId).setSelectionPolicy(sp);
-            cout << "PlanID: " + to_string(planId) << endl;
-            cout << "PreviousPolicy: " + st << endl;
-            cout << "newPolicy: " + sp->toString() << endl;
+            string newName = sp->toString();
+            simulation.getPlan(planId).setSelectionPolicy(sp); // the plan takes the policy over
+            simulation.getOutput() << "PlanID: " + to_string(planId) << endl;
+            simulation.getOutput() << "PreviousPolicy: " + st << endl;
+            simulation.getOutput() << "newPolicy: " + newName << endl;
             complete();
         }
     }
     catch (const std::runtime_error &e)
     {
         error("Cannot change selection policy");
-        cout << getErrorMsg() << endl;
+        simulation.getOutput() << getErrorMsg() << endl;
     }
 }
 
@@ -250,7 +279,12 @@ void AddPlan::act(Simulation &simulation)
     if ((!simulation.isSettlementExists(settlementName)) || ((selectionPolicy != "nve" && selectionPolicy != "bal" && selectionPolicy != "eco" && selectionPolicy != "env")))
     {
         error("Cannot create this plan");
-        cout << getErrorMsg() << endl;
+        simulation.getOutput() << getErrorMsg() << endl;
+    }
+    else if (Memory::wouldExceedSoftLimit())
+    {
+        error("Memory limit reached");
+        simulation.getOutput() << getErrorMsg() << endl;
     }
     else
     {
@@ -294,14 +328,16 @@ void PrintPlanStatus::act(Simulation &simulation)
 {
     try
     {
-        Plan plan = simulation.getPlan(planId);
-        cout << plan.toString() << endl;
+        const Plan &plan = simulation.readPlan(planId);
+        ReportWriter report(simulation.getOutput());
+        report.planStatus(plan, simulation.getWorld());
+        report.endReport();
         complete();
     }
     catch (const std::runtime_error &e)
     {
         error("Plan doesn't exist");
-        cout << getErrorMsg() << endl;
+        simulation.getOutput() << getErrorMsg() << endl;
     }
 }
 
@@ -317,6 +353,189 @@ const string PrintPlanStatus::toString() const
 
 // end class
 
+PrintPlanChanges::PrintPlanChanges(int planId, const string &cursor) : planId(planId), cursor(cursor)
+{
+}
+
+void PrintPlanChanges::act(Simulation &simulation)
+{
+    try
+    {
+        const Plan &plan = simulation.readPlan(planId);
+        PlanCursor seen = {-1, 0, 0};
+        char rest;
+        if (sscanf(cursor.c_str(), "%d:%d:%d%c", &seen.generation, &seen.completed, &seen.started, &rest) != 3)
+        {
+            seen.generation = -1;
+        }
+        ReportWriter report(simulation.getOutput());
+        report.planChanges(plan, simulation.getWorld(), seen, plan.getCursor(simulation.getGeneration()));
+        report.endReport();
+        complete();
+    }
+    catch (const std::runtime_error &e)
+    {
+        error("Plan doesn't exist");
+        simulation.getOutput() << getErrorMsg() << endl;
+    }
+}
+
+PrintPlanChanges *PrintPlanChanges::clone() const
+{
+    return new PrintPlanChanges(planId, cursor);
+}
+
+const string PrintPlanChanges::toString() const
+{
+    return "planStatus " + to_string(planId) + " --since " + cursor + " " + statusToString(getStatus());
+}
+
+// end class
+
+PrintChangedPlans::PrintChangedPlans()
+{
+}
+
+void PrintChangedPlans::act(Simulation &simulation)
+{
+    // comparing two counts per plan is all an unchanged plan costs
+    ReportWriter report(simulation.getOutput());
+    PlanWorld world = simulation.getWorld();
+    int generation = simulation.getGeneration();
+    int changed = 0;
+    for (int i = 0; i < simulation.getPlanCount(); i++)
+    {
+        const Plan &plan = simulation.planAt(i);
+        PlanCursor now = plan.getCursor(generation);
+        PlanCursor &seen = simulation.reportedCursor(i);
+        if (seen.generation == now.generation && seen.completed == now.completed && seen.started == now.started)
+        {
+            continue;
+        }
+        report.planChanges(plan, world, seen, now);
+        report.endReport();
+        seen = now;
+        changed++;
+    }
+    report.flush();
+    simulation.getOutput() << "ChangedPlans: " << changed << endl;
+    complete();
+}
+
+PrintChangedPlans *PrintChangedPlans::clone() const
+{
+    return new PrintChangedPlans();
+}
+
+const string PrintChangedPlans::toString() const
+{
+    return "planStatus all --changed " + statusToString(getStatus());
+}
+
+// end class
+
+// Compare Policies
+ComparePolicies::ComparePolicies(const int planId, const int numOfSteps) : planId(planId), numOfSteps(numOfSteps)
+{
+}
+
+void ComparePolicies::act(Simulation &simulation)
+{
+    const string policies[] = {"nve", "bal", "eco", "env"};
+    const int policiesNum = 4;
+    vector<Plan> forks;
+    forks.reserve(policiesNum);
+    // each fork finishes facilities into a store of its own, so the simulation's is never written
+    vector<FacilityStore> stores(policiesNum);
+    vector<PlanWorld> worlds(policiesNum, simulation.getWorld());
+    try
+    {
+        const Plan &plan = simulation.readPlan(planId);
+        for (const string &policy : policies)
+        {
+            int i = forks.size();
+            forks.push_back(plan); // shares the settlement and the facilities catalog
+            worlds[i].facilities = &stores[i];
+            forks.back().copyFacilities(simulation.getWorld(), worlds[i]);
+            SelectionPolicy *sp = nullptr;
+            if (policy == "nve")
+            {
+                sp = new NaiveSelection();
+            }
+            else if (policy == "bal")
+            {
+                sp = new BalancedSelection(0, 0, 0);
+            }
+            else if (policy == "eco")
+            {
+                sp = new EconomySelection();
+            }
+            else
+            {
+                sp = new SustainabilitySelection();
+            }
+            // the plan's own policy keeps its progress, like a plain step would
+            if (sp->getKind() == plan.getPolicyKind())
+            {
+                delete sp;
+            }
+            else
+            {
+                forks.back().setSelectionPolicy(sp);
+            }
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        error("Plan doesn't exist");
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
+
+    // forks are independent and only read the catalog, so they can step concurrently
+    vector<std::thread> workers;
+    for (int f = 0; f < policiesNum; f++)
+    {
+        Plan &fork = forks[f];
+        PlanWorld &world = worlds[f];
+        int steps = numOfSteps;
+        workers.push_back(std::thread([&fork, &world, steps]()
+                                      {
+                                          world.stats = &Stats::local();
+                                          for (int i = 0; i < steps; i++)
+                                          {
+                                              fork.step(world);
+                                          } }));
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    simulation.getOutput() << "PlanID: " << planId << endl;
+    simulation.getOutput() << "Steps: " << numOfSteps << endl;
+    simulation.getOutput() << "SelectionPolicy LifeQualityScore EconomyScore EnvironmentScore Operational UnderConstruction" << endl;
+    for (int i = 0; i < policiesNum; i++)
+    {
+        const Plan &fork = forks[i];
+        simulation.getOutput() << policies[i] << " " << fork.getlifeQualityScore() << " " << fork.getEconomyScore() << " " << fork.getEnvironmentScore()
+                               << " " << fork.getFacilitiesCount() << " " << fork.getUnderConstructionCount() << endl;
+    }
+    complete();
+}
+
+ComparePolicies *ComparePolicies::clone() const
+{
+    return new ComparePolicies(planId, numOfSteps);
+}
+
+const string ComparePolicies::toString() const
+{
+    return "compare " + to_string(planId) + " " + to_string(numOfSteps) + " " + statusToString(getStatus());
+}
+
+// end class
+
 PrintActionsLog::PrintActionsLog()
 {
 }
@@ -327,7 +546,7 @@ void PrintActionsLog::act(Simulation &simulation)
 
     for (const auto &action : actionsLog)
     {
-        cout << action->toString() << endl;
+        simulation.getOutput() << action->toString() << endl;
     }
     complete();
 }
@@ -350,14 +569,14 @@ void Close::act(Simulation &simulation)
 {
     complete();
     simulation.SetIsRunning(false);
-    for (const auto &plan : simulation.getPlans())
+    PlanWorld world = simulation.getWorld();
+    ReportWriter report(simulation.getOutput());
+    for (const Plan &plan : simulation.planStates())
     {
-        std::cout << "Plan ID: " << plan.getID() << std::endl;
-        std::cout << "Settlement Name: " << plan.getSettlement().getName() << std::endl;
-        std::cout << "Life Quality Score: " << plan.getlifeQualityScore() << std::endl;
-        std::cout << "Economy Score: " << plan.getEconomyScore() << std::endl;
-        std::cout << "Environment Score: " << plan.getEnvironmentScore() << std::endl;
+        report.planSummary(plan, world);
     }
+    report.flush();
+    simulation.getOutput().flush();
 }
 
 Close *Close::clone() const
@@ -377,11 +596,24 @@ BackupSimulation::BackupSimulation()
 
 void BackupSimulation::act(Simulation &simulation)
 {
+    // the new backup replaces the old one, so only the difference counts against the limit
+    long long footprint = simulation.memoryFootprint();
+    long long replaced = backup != nullptr ? Memory::backupBytes() : 0;
+    if (Memory::wouldExceedSoftLimit(footprint - replaced))
+    {
+        error("Memory limit reached");
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
     if (backup != nullptr)
     {
         delete backup;
     }
-    backup = new Simulation(simulation);
+    {
+        Trace::Span span("backup copy");
+        backup = new Simulation(simulation);
+    }
+    Memory::setBackup(footprint);
 
     complete();
 }
@@ -409,11 +641,14 @@ void RestoreSimulation::act(Simulation &simulation)
     if (backup == nullptr)
     {
         error("No backup available");
-        cout << getErrorMsg() << endl;
+        simulation.getOutput() << getErrorMsg() << endl;
     }
     else
     {
-        simulation = *backup;
+        {
+            Trace::Span span("restore copy");
+            simulation = *backup;
+        }
         complete();
     }
 }
@@ -426,4 +661,225 @@ RestoreSimulation *RestoreSimulation::clone() const
 const string RestoreSimulation::toString() const
 {
     return "restore " + statusToString(getStatus());
-}
\ No newline at end of file
+}
+
+// end class
+
+// Print Stats
+PrintStats::PrintStats(bool json) : json(json)
+{
+}
+
+void PrintStats::act(Simulation &simulation)
+{
+    Stats::print(simulation.getOutput(), json);
+    complete();
+}
+
+PrintStats *PrintStats::clone() const
+{
+    return new PrintStats(json);
+}
+
+const string PrintStats::toString() const
+{
+    return string("stats") + (json ? " --json " : " ") + statusToString(getStatus());
+}
+
+PrintMemory::PrintMemory()
+{
+}
+
+void PrintMemory::act(Simulation &simulation)
+{
+    Memory::print(simulation.getOutput());
+    complete();
+}
+
+PrintMemory *PrintMemory::clone() const
+{
+    return new PrintMemory();
+}
+
+const string PrintMemory::toString() const
+{
+    return "memory " + statusToString(getStatus());
+}
+
+ExportPlans::ExportPlans(const string &path) : path(path)
+{
+}
+
+void ExportPlans::act(Simulation &simulation)
+{
+    string failed;
+    if (PlanExport::takeFailure(failed))
+    {
+        // an earlier export's background write failed: say so before writing anything else
+        error("Cannot write " + failed);
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
+    if (!PlanExport::start(simulation, path))
+    {
+        error("Cannot write " + path);
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+ExportPlans *ExportPlans::clone() const
+{
+    return new ExportPlans(path);
+}
+
+const string ExportPlans::toString() const
+{
+    return "export " + path + " " + statusToString(getStatus());
+}
+
+PrintTopPlans::PrintTopPlans(const string &metric, int count) : metric(metric), count(count)
+{
+}
+
+void PrintTopPlans::act(Simulation &simulation)
+{
+    const string names[] = {"life", "economy", "env", "balance"};
+    int kind = std::find(names, names + Leaderboard::METRIC_COUNT, metric) - names;
+    if (kind == Leaderboard::METRIC_COUNT || count <= 0)
+    {
+        error("Cannot rank plans");
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
+    vector<int> best;
+    simulation.getLeaderboard().top(static_cast<Leaderboard::Metric>(kind), count, best);
+    PlanWorld world = simulation.getWorld();
+    for (int index : best)
+    {
+        const Plan &plan = simulation.planAt(index);
+        simulation.getOutput() << "PlanID: " << plan.getID() << " SettlementName: " << plan.getSettlement(world).getName()
+                               << " LifeQualityScore: " << plan.getlifeQualityScore() << " EconomyScore: " << plan.getEconomyScore()
+                               << " EnvironmentScore: " << plan.getEnvironmentScore() << "\n";
+    }
+    simulation.getOutput().flush();
+    complete();
+}
+
+PrintTopPlans *PrintTopPlans::clone() const
+{
+    return new PrintTopPlans(metric, count);
+}
+
+const string PrintTopPlans::toString() const
+{
+    return "top " + metric + " " + to_string(count) + " " + statusToString(getStatus());
+}
+
+PrintSettlementStatus::PrintSettlementStatus(const string &settlementName) : settlementName(settlementName)
+{
+}
+
+void PrintSettlementStatus::act(Simulation &simulation)
+{
+    if (!simulation.isSettlementExists(settlementName))
+    {
+        error("Settlement doesn't exist");
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
+    const SettlementAggregates::Totals &totals = simulation.getSettlementTotals(settlementName);
+    double plans = totals.plans == 0 ? 1 : totals.plans;
+    std::ostream &out = simulation.getOutput();
+    out << "SettlementName: " << settlementName << "\n"
+        << "Plans: " << totals.plans << "\n"
+        << "LifeQualityScore: " << totals.lifeQualityScore << " Mean: " << totals.lifeQualityScore / plans << "\n"
+        << "EconomyScore: " << totals.economyScore << " Mean: " << totals.economyScore / plans << "\n"
+        << "EnvironmentScore: " << totals.environmentScore << " Mean: " << totals.environmentScore / plans << "\n"
+        << "OperationalFacilities: " << totals.operational << "\n"
+        << "FacilitiesUnderConstruction: " << totals.underConstruction << endl;
+    complete();
+}
+
+PrintSettlementStatus *PrintSettlementStatus::clone() const
+{
+    return new PrintSettlementStatus(settlementName);
+}
+
+const string PrintSettlementStatus::toString() const
+{
+    return "settlementStatus " + settlementName + " " + statusToString(getStatus());
+}
+
+StepUntil::StepUntil(int maxSteps, const string &condition) : maxSteps(maxSteps), condition(condition)
+{
+}
+
+void StepUntil::act(Simulation &simulation)
+{
+    StepCondition compiled;
+    if (maxSteps < 0 || !compiled.compile(condition))
+    {
+        error("Cannot step until this condition");
+        simulation.getOutput() << getErrorMsg() << endl;
+        return;
+    }
+    try
+    {
+        bool held = simulation.stepUntil(maxSteps, compiled);
+        simulation.getOutput() << "Tick: " << simulation.getTick() << " ConditionMet: " << (held ? "true" : "false") << endl;
+        complete();
+    }
+    catch (const std::runtime_error &e)
+    {
+        error("Plan doesn't exist");
+        simulation.getOutput() << getErrorMsg() << endl;
+    }
+}
+
+StepUntil *StepUntil::clone() const
+{
+    return new StepUntil(maxSteps, condition);
+}
+
+const string StepUntil::toString() const
+{
+    return "stepUntil " + to_string(maxSteps) + " " + condition + " " + statusToString(getStatus());
+}
+
+AddPlans::AddPlans(const string &settlementName, const string &selectionPolicy, int count) : settlementName(settlementName), selectionPolicy(selectionPolicy), count(count)
+{
+}
+
+void AddPlans::act(Simulation &simulation)
+{
+    const string policies[] = {"nve", "bal", "eco", "env"};
+    int policy = std::find(policies, policies + 4, selectionPolicy) - policies;
+    long long created = simulation.bulkPlanCount(settlementName, count);
+    if (created < 0 || policy == 4)
+    {
+        error("Cannot create this plan");
+        simulation.getOutput() << getErrorMsg() << endl;
+    }
+    else if (Memory::wouldExceedSoftLimit(Simulation::planFootprint(created)))
+    {
+        error("Memory limit reached");
+        simulation.getOutput() << getErrorMsg() << endl;
+    }
+    else
+    {
+        simulation.addPlans(settlementName, static_cast<SelectionPolicyKind>(policy), count);
+        complete();
+    }
+}
+
+AddPlans *AddPlans::clone() const
+{
+    return new AddPlans(settlementName, selectionPolicy, count);
+}
+
+const string AddPlans::toString() const
+{
+    return "plans " + settlementName + " " + selectionPolicy + " " + to_string(count) + " " + statusToString(getStatus());
+}
@@ -0,0 +1,187 @@
+#include "BatchRunner.h"
+#include "Action.h"
+#include "Memory.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+
+using namespace std;
+
+extern thread_local Simulation *backup;
+
+static vector<string> readLines(const string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    vector<string> lines;
+    string line;
+    while (std::getline(file, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static string jsonString(const string &text)
+{
+    string quoted = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+BatchRunner::BatchRunner(const string &configsPath, const string &scriptPath, int jobs, const string &resultsPath) : configs(), script(readLines(scriptPath)), jobs(jobs), resultsPath(resultsPath), results(), catalogsLock(), catalogs()
+{
+    for (const string &line : readLines(configsPath))
+    {
+        if (!line.empty() && line[0] != '#')
+        {
+            configs.push_back(line);
+        }
+    }
+    results.resize(configs.size());
+}
+
+void BatchRunner::run()
+{
+    std::atomic<int> next(0);
+    vector<std::thread> workers;
+    for (int i = 0; i < jobs; i++)
+    {
+        workers.push_back(std::thread([this, &next]()
+                                      {
+                                          int index;
+                                          while ((index = next++) < static_cast<int>(configs.size()))
+                                          {
+                                              runJob(index);
+                                          } }));
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    std::ofstream file;
+    std::ostream *out = &cout;
+    if (!resultsPath.empty())
+    {
+        file.open(resultsPath);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Cannot open file: " + resultsPath);
+        }
+        out = &file;
+    }
+    for (const string &result : results)
+    {
+        *out << result << '\n';
+    }
+    out->flush();
+}
+
+// swaps the catalog for an identical one already loaded by another run, if there is one
+FacilityCatalog BatchRunner::shareCatalog(const FacilityCatalog &catalog)
+{
+    std::ostringstream key;
+    for (int i = 0; i < catalog.size(); i++)
+    {
+        const FacilityStats &facility = catalog[i];
+        key << catalog.getName(i) << ' ' << static_cast<int>(facility.getCategory()) << ' ' << facility.getCost() << ' '
+            << facility.getLifeQualityScore() << ' ' << facility.getEconomyScore() << ' ' << facility.getEnvironmentScore() << '\n';
+    }
+    std::lock_guard<std::mutex> lock(catalogsLock);
+    auto it = catalogs.find(key.str());
+    if (it != catalogs.end())
+    {
+        return it->second;
+    }
+    catalogs.insert(std::make_pair(key.str(), catalog));
+    return catalog;
+}
+
+void BatchRunner::runJob(int index)
+{
+    const string &config = configs[index];
+    std::ostringstream result;
+    result << "{\"config\":" << jsonString(config);
+    try
+    {
+        Simulation simulation(config);
+        simulation.setCatalog(shareCatalog(simulation.getCatalog()));
+        std::ostream discard(nullptr); // the per-command text is not part of the results
+        simulation.setOutput(discard);
+        simulation.open();
+        for (const string &line : script)
+        {
+            if (!simulation.getIsRunning())
+            {
+                break;
+            }
+            BaseAction *action = nullptr;
+            try
+            {
+                action = Simulation::parseAction(line);
+            }
+            catch (const std::exception &e)
+            {
+                action = nullptr;
+            }
+            if (action != nullptr)
+            {
+                simulation.execute(action);
+            }
+        }
+
+        int errors = 0;
+        vector<BaseAction *> actionsLog = simulation.getActionsLog();
+        for (BaseAction *action : actionsLog)
+        {
+            if (action->getStatus() == ActionStatus::ERROR)
+            {
+                errors++;
+            }
+        }
+        result << ",\"tick\":" << simulation.getTick() << ",\"actions\":" << actionsLog.size() << ",\"errors\":" << errors << ",\"plans\":[";
+        bool first = true;
+        PlanWorld world = simulation.getWorld();
+        for (const Plan &plan : simulation.planStates())
+        {
+            result << (first ? "" : ",") << "{\"id\":" << plan.getID()
+                   << ",\"settlement\":" << jsonString(plan.getSettlement(world).getName())
+                   << ",\"policy\":" << jsonString(plan.getSelectionPolicyName())
+                   << ",\"status\":\"" << (plan.getStatus() == PlanStatus::BUSY ? "BUSY" : "AVALIABLE") << "\""
+                   << ",\"lifeQuality\":" << plan.getlifeQualityScore()
+                   << ",\"economy\":" << plan.getEconomyScore()
+                   << ",\"environment\":" << plan.getEnvironmentScore()
+                   << ",\"operational\":" << plan.getFacilitiesCount()
+                   << ",\"underConstruction\":" << plan.getUnderConstructionCount() << "}";
+            first = false;
+        }
+        result << "]}";
+    }
+    catch (const std::exception &e)
+    {
+        result << ",\"error\":" << jsonString(e.what()) << "}";
+    }
+
+    // backups belong to the run that made them
+    if (backup != nullptr)
+    {
+        delete backup;
+        backup = nullptr;
+        Memory::setBackup(0);
+    }
+    results[index] = result.str();
+}
@@ -0,0 +1,105 @@
+#include "EventFeed.h"
+
+using namespace std;
+
+static const char *const EVENT_NAMES[] = {"facility_started", "facility_completed", "plan_busy"};
+
+EventFeed::EventFeed(const string &path, bool binary) : binary(binary), file(path, std::ios::binary), batch(), pending(), pendingLock(), wake(), stopping(false), writer()
+{
+    if (!file)
+    {
+        return;
+    }
+    if (binary)
+    {
+        file << "PLANEV1\n";
+    }
+    writer = std::thread(&EventFeed::writeLoop, this);
+}
+
+bool EventFeed::isOpen() const
+{
+    return writer.joinable();
+}
+
+void EventFeed::onPlanChanged(int tick, const Plan &plan)
+{
+}
+
+void EventFeed::onPlanEvent(const PlanEvent &event)
+{
+    if (binary)
+    {
+        batch.push_back(static_cast<char>(event.kind));
+        appendInt(event.tick);
+        appendInt(event.planId);
+        appendInt(event.facility);
+        appendInt(event.lifeQualityDelta);
+        appendInt(event.economyDelta);
+        appendInt(event.environmentDelta);
+        return;
+    }
+    batch += "{\"tick\":" + to_string(event.tick) + ",\"plan\":" + to_string(event.planId) + ",\"event\":\"" + EVENT_NAMES[static_cast<int>(event.kind)] +
+             "\",\"facility\":" + to_string(event.facility) + ",\"lifeQuality\":" + to_string(event.lifeQualityDelta) +
+             ",\"economy\":" + to_string(event.economyDelta) + ",\"environment\":" + to_string(event.environmentDelta) + "}\n";
+}
+
+void EventFeed::onTickEnd(int tick)
+{
+    if (batch.empty() || !isOpen())
+    {
+        batch.clear();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingLock);
+        pending += batch;
+    }
+    batch.clear();
+    wake.notify_one();
+}
+
+void EventFeed::appendInt(int value)
+{
+    unsigned bits = static_cast<unsigned>(value);
+    for (int i = 0; i < 4; i++)
+    {
+        batch.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+}
+
+void EventFeed::writeLoop()
+{
+    string writing;
+    std::unique_lock<std::mutex> lock(pendingLock);
+    while (true)
+    {
+        wake.wait(lock, [this]
+                  { return stopping || !pending.empty(); });
+        if (pending.empty())
+        {
+            return; // stopping, and everything is out
+        }
+        writing.swap(pending);
+        lock.unlock();
+        file.write(writing.data(), writing.size());
+        file.flush();
+        writing.clear();
+        lock.lock();
+    }
+}
+
+EventFeed::~EventFeed()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+    onTickEnd(0);
+    {
+        std::lock_guard<std::mutex> lock(pendingLock);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
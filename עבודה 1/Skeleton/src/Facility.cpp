@@ -1,6 +1,9 @@
 #include "Facility.h"
 #include <iostream>
 #include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
@@ -115,4 +118,28 @@ FacilityStatus Facility::step()
         setStatus(FacilityStatus::OPERATIONAL);
     }
     return status;
-}
\ No newline at end of file
+}
+unsigned Facility::countdown(int *timeLeft, int count)
+{
+    unsigned completed = 0;
+#ifdef __SSE2__
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+    for (int i = 0; i < count; i += 4)
+    {
+        __m128i active = _mm_cmpgt_epi32(_mm_set1_epi32(count - i), lanes); // padding lanes stay as they are
+        __m128i timers = _mm_loadu_si128(reinterpret_cast<__m128i *>(timeLeft + i));
+        timers = _mm_sub_epi32(timers, _mm_and_si128(one, active));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(timeLeft + i), timers);
+        unsigned done = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(_mm_cmplt_epi32(timers, one), active)));
+        completed |= done << i;
+    }
+#else
+    for (int i = 0; i < count; i++)
+    {
+        timeLeft[i]--;
+        completed |= static_cast<unsigned>(timeLeft[i] <= 0) << i;
+    }
+#endif
+    return completed;
+}
@@ -0,0 +1,138 @@
+#include "FacilityCatalog.h"
+#include "Memory.h"
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+static const int MAX_PRICE = (1 << 29) - 1;
+
+// a name's characters, when they do not fit in the string itself
+static long long nameHeapBytes(const string &name)
+{
+    const char *inside = reinterpret_cast<const char *>(&name);
+    return name.data() >= inside && name.data() < inside + sizeof(string) ? 0 : name.capacity() + 1;
+}
+
+// Storage
+FacilityCatalog::Storage::Storage() : statsChunks(), nameChunks(), size(0), appendLock()
+{
+    for (int i = 0; i < MAX_CHUNKS; i++)
+    {
+        statsChunks[i].store(nullptr, std::memory_order_relaxed);
+        nameChunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+FacilityCatalog::Storage::~Storage()
+{
+    int published = size.load(std::memory_order_acquire);
+    long long nameBytes = 0;
+    for (int i = 0; i < published; i++)
+    {
+        nameBytes += nameHeapBytes(name(i));
+        const_cast<string &>(name(i)).~string();
+    }
+    long long chunkBytes = 0;
+    for (int i = 0; i < MAX_CHUNKS; i++)
+    {
+        if (statsChunks[i].load(std::memory_order_relaxed) != nullptr)
+        {
+            chunkBytes += (sizeof(FacilityStats) + sizeof(string)) << (FIRST_CHUNK_SHIFT + i);
+        }
+        ::operator delete(statsChunks[i].load(std::memory_order_relaxed));
+        ::operator delete(nameChunks[i].load(std::memory_order_relaxed));
+    }
+    Memory::released(Memory::CATALOG, chunkBytes + nameBytes, published);
+}
+
+bool FacilityCatalog::Storage::append(int expectedSize, const FacilityStats &stats, const string &name)
+{
+    std::lock_guard<std::mutex> lock(appendLock);
+    if (size.load(std::memory_order_relaxed) != expectedSize)
+    {
+        return false;
+    }
+    int chunk;
+    int offset;
+    locate(expectedSize, chunk, offset);
+    if (chunk >= MAX_CHUNKS)
+    {
+        throw std::runtime_error("Facility catalog is full");
+    }
+    FacilityStats *statsEntries = statsChunks[chunk].load(std::memory_order_relaxed);
+    string *nameEntries = nameChunks[chunk].load(std::memory_order_relaxed);
+    if (statsEntries == nullptr)
+    {
+        int entries = 1 << (FIRST_CHUNK_SHIFT + chunk);
+        statsEntries = static_cast<FacilityStats *>(::operator new(sizeof(FacilityStats) * entries));
+        nameEntries = static_cast<string *>(::operator new(sizeof(string) * entries));
+        statsChunks[chunk].store(statsEntries, std::memory_order_release);
+        nameChunks[chunk].store(nameEntries, std::memory_order_release);
+        Memory::allocated(Memory::CATALOG, (sizeof(FacilityStats) + sizeof(string)) * entries, 0);
+    }
+    statsEntries[offset] = stats;
+    new (nameEntries + offset) string(name);
+    Memory::allocated(Memory::CATALOG, nameHeapBytes(nameEntries[offset]));
+    size.store(expectedSize + 1, std::memory_order_release); // the entry is visible from here on
+    return true;
+}
+
+const string &FacilityCatalog::Storage::name(int index) const
+{
+    int chunk;
+    int offset;
+    locate(index, chunk, offset);
+    return nameChunks[chunk].load(std::memory_order_acquire)[offset];
+}
+
+int FacilityCatalog::Storage::published() const
+{
+    return size.load(std::memory_order_acquire);
+}
+
+// end class
+
+FacilityCatalog::FacilityCatalog() : storage(std::make_shared<Storage>()), count(0)
+{
+}
+
+int FacilityCatalog::size() const
+{
+    return count;
+}
+
+const string &FacilityCatalog::getName(int index) const
+{
+    return storage->name(index);
+}
+
+FacilityType FacilityCatalog::getType(int index) const
+{
+    const FacilityStats &stats = storage->stats(index);
+    return FacilityType(storage->name(index), stats.getCategory(), stats.getCost(), stats.getLifeQualityScore(), stats.getEconomyScore(), stats.getEnvironmentScore());
+}
+
+void FacilityCatalog::push_back(const FacilityType &facility)
+{
+    FacilityStats stats;
+    stats.price = std::max(-MAX_PRICE, std::min(MAX_PRICE, facility.getCost()));
+    stats.category = static_cast<unsigned>(facility.getCategory());
+    stats.lifeQuality_score = facility.getLifeQualityScore();
+    stats.economy_score = facility.getEconomyScore();
+    stats.environment_score = facility.getEnvironmentScore();
+
+    if (!storage->append(count, stats, facility.getName()))
+    {
+        // another view added its own entries after ours, continue on a private copy
+        std::shared_ptr<Storage> copied = std::make_shared<Storage>();
+        for (int i = 0; i < count; i++)
+        {
+            copied->append(i, storage->stats(i), storage->name(i));
+        }
+        copied->append(count, stats, facility.getName());
+        storage = copied;
+    }
+    count++;
+}
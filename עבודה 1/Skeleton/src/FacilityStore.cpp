@@ -0,0 +1,120 @@
+#include "FacilityStore.h"
+#include "Memory.h"
+#include <algorithm>
+
+using namespace std;
+
+FacilityStore::FacilityStore() : chunks()
+{
+}
+
+int FacilityStore::append(int tail, int count, int facility)
+{
+    int position = count % (CHUNK_SIZE - 1);
+    if (position == 0)
+    {
+        // the last chunk is full (or there is none yet), chain a new one
+        int chunk = chunks.size() / CHUNK_SIZE;
+        size_t capacity = chunks.capacity();
+        chunks.resize(chunks.size() + CHUNK_SIZE, -1);
+        Memory::allocated(Memory::FACILITIES, (chunks.capacity() - capacity) * sizeof(int));
+        chunks[chunk * CHUNK_SIZE] = count == 0 ? -1 : tail;
+        tail = chunk;
+    }
+    chunks[tail * CHUNK_SIZE + 1 + position] = facility;
+    return tail;
+}
+
+void FacilityStore::read(int tail, int count, vector<int> &facilities) const
+{
+    readFrom(tail, count, 0, facilities);
+}
+
+void FacilityStore::readFrom(int tail, int count, int first, vector<int> &facilities) const
+{
+    facilities.resize(count > first ? count - first : 0);
+    int chunk = tail;
+    int end = count;
+    while (end > first)
+    {
+        // walk back from the last chunk, filling the list from its end
+        int start = (end - 1) / (CHUNK_SIZE - 1) * (CHUNK_SIZE - 1);
+        for (int i = std::max(start, first); i < end; i++)
+        {
+            facilities[i - first] = chunks[chunk * CHUNK_SIZE + 1 + (i - start)];
+        }
+        end = start;
+        chunk = chunks[chunk * CHUNK_SIZE];
+    }
+}
+
+int FacilityStore::copyList(int tail, int count, FacilityStore &destination) const
+{
+    vector<int> facilities;
+    read(tail, count, facilities);
+    int copyTail = -1;
+    for (int i = 0; i < count; i++)
+    {
+        copyTail = destination.append(copyTail, i, facilities[i]);
+    }
+    return copyTail;
+}
+
+void FacilityStore::account(long long bytes, long long chunkCount) const
+{
+    if (bytes != 0 || chunkCount != 0)
+    {
+        Memory::allocated(Memory::FACILITIES, bytes, chunkCount);
+    }
+}
+
+long long FacilityStore::memoryBytes() const
+{
+    return static_cast<long long>(chunks.size()) * sizeof(int); // a copy takes no spare capacity
+}
+
+void FacilityStore::clear()
+{
+    Memory::released(Memory::FACILITIES, chunks.capacity() * sizeof(int), chunks.size() / CHUNK_SIZE);
+    vector<int>().swap(chunks);
+}
+
+// Rule of 5
+///////////////////////////////////////
+
+FacilityStore::FacilityStore(const FacilityStore &other) : chunks(other.chunks)
+{
+    account(chunks.capacity() * sizeof(int), chunks.size() / CHUNK_SIZE);
+}
+
+FacilityStore &FacilityStore::operator=(const FacilityStore &other)
+{
+    if (this != &other)
+    {
+        clear();
+        chunks = other.chunks;
+        account(chunks.capacity() * sizeof(int), chunks.size() / CHUNK_SIZE);
+    }
+    return *this;
+}
+
+FacilityStore::~FacilityStore()
+{
+    clear();
+}
+
+FacilityStore::FacilityStore(FacilityStore &&other) : chunks(std::move(other.chunks))
+{
+    other.chunks.clear();
+}
+
+FacilityStore &FacilityStore::operator=(FacilityStore &&other)
+{
+    if (this != &other)
+    {
+        clear();
+        chunks = std::move(other.chunks);
+        other.chunks.clear();
+    }
+    return *this;
+}
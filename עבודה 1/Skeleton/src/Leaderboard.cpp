@@ -0,0 +1,156 @@
+#include "Leaderboard.h"
+#include <algorithm>
+#include <queue>
+
+using namespace std;
+
+Leaderboard::Leaderboard() : leaves(1), values(), simulated(), trees(), mirrors()
+{
+    for (int metric = 0; metric < METRIC_COUNT; metric++)
+    {
+        trees[metric].assign(2, -1);
+    }
+}
+
+void Leaderboard::addPlan(int index, int representative, const Plan &plan)
+{
+    for (int metric = 0; metric < METRIC_COUNT; metric++)
+    {
+        values[metric].resize(index + 1, 0);
+    }
+    simulated.resize(index + 1, false);
+    mirrors.resize(index + 1);
+    if (index >= leaves)
+    {
+        grow();
+    }
+    if (representative == index)
+    {
+        setScores(index, plan);
+    }
+    else
+    {
+        mirrors[representative].push_back(index);
+    }
+}
+
+void Leaderboard::setScores(int representative, const Plan &plan)
+{
+    int life = plan.getlifeQualityScore();
+    int eco = plan.getEconomyScore();
+    int env = plan.getEnvironmentScore();
+    if (simulated[representative] && values[LIFE_QUALITY][representative] == life && values[ECONOMY][representative] == eco && values[ENVIRONMENT][representative] == env)
+    {
+        return; // only started facilities
+    }
+    values[LIFE_QUALITY][representative] = life;
+    values[ECONOMY][representative] = eco;
+    values[ENVIRONMENT][representative] = env;
+    values[BALANCE][representative] = std::min(life, std::min(eco, env)) - std::max(life, std::max(eco, env));
+    simulated[representative] = true;
+    refresh(representative);
+}
+
+void Leaderboard::detach(int index, int representative, const Plan &plan)
+{
+    vector<int> &group = mirrors[representative];
+    group.erase(std::find(group.begin(), group.end(), index));
+    setScores(index, plan);
+}
+
+void Leaderboard::handOver(int representative, int successor, const Plan &plan)
+{
+    // mirrors are kept in index order and the successor is the first of them
+    mirrors[successor].assign(mirrors[representative].begin() + 1, mirrors[representative].end());
+    mirrors[representative].clear();
+    setScores(successor, plan);
+}
+
+void Leaderboard::top(Metric metric, int count, vector<int> &indices) const
+{
+    indices.clear();
+    const vector<int> &tree = trees[metric];
+    auto worse = [this, metric, &tree](int first, int second)
+    {
+        return better(metric, tree[second], tree[first]);
+    };
+    std::priority_queue<int, vector<int>, decltype(worse)> nodes(worse);
+    if (tree[1] != -1)
+    {
+        nodes.push(1);
+    }
+    while (!nodes.empty() && static_cast<int>(indices.size()) < count)
+    {
+        int node = nodes.top();
+        nodes.pop();
+        if (node >= leaves)
+        {
+            int plan = node - leaves;
+            indices.push_back(plan);
+            for (size_t i = 0; i < mirrors[plan].size() && static_cast<int>(indices.size()) < count; i++)
+            {
+                indices.push_back(mirrors[plan][i]);
+            }
+            continue;
+        }
+        for (int child = 2 * node; child <= 2 * node + 1; child++)
+        {
+            if (tree[child] != -1)
+            {
+                nodes.push(child);
+            }
+        }
+    }
+}
+
+bool Leaderboard::better(Metric metric, int first, int second) const
+{
+    if (first == -1 || second == -1)
+    {
+        return second == -1 && first != -1;
+    }
+    int firstValue = values[metric][first];
+    int secondValue = values[metric][second];
+    return firstValue > secondValue || (firstValue == secondValue && first < second);
+}
+
+void Leaderboard::refresh(int index)
+{
+    for (int metric = 0; metric < METRIC_COUNT; metric++)
+    {
+        Metric kind = static_cast<Metric>(metric);
+        vector<int> &tree = trees[metric];
+        int node = leaves + index;
+        tree[node] = simulated[index] ? index : -1;
+        for (node /= 2; node >= 1; node /= 2)
+        {
+            int left = tree[2 * node];
+            int right = tree[2 * node + 1];
+            tree[node] = better(kind, right, left) ? right : left;
+        }
+    }
+}
+
+void Leaderboard::grow()
+{
+    while (leaves < static_cast<int>(simulated.size()))
+    {
+        leaves *= 2;
+    }
+    for (int metric = 0; metric < METRIC_COUNT; metric++)
+    {
+        Metric kind = static_cast<Metric>(metric);
+        vector<int> &tree = trees[metric];
+        tree.assign(2 * leaves, -1);
+        for (size_t i = 0; i < simulated.size(); i++)
+        {
+            tree[leaves + i] = simulated[i] ? static_cast<int>(i) : -1;
+        }
+        for (int node = leaves - 1; node >= 1; node--)
+        {
+            int left = tree[2 * node];
+            int right = tree[2 * node + 1];
+            tree[node] = better(kind, right, left) ? right : left;
+        }
+    }
+}
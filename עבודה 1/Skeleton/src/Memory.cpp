@@ -0,0 +1,109 @@
+#include "Memory.h"
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+    struct Account
+    {
+        std::atomic<long long> bytes;
+        std::atomic<long long> objects;
+        std::atomic<long long> peak;
+    };
+}
+
+static Account accounts[Memory::CATEGORY_COUNT];
+static std::atomic<long long> softLimit(0);
+static const char *const CATEGORY_NAMES[Memory::CATEGORY_COUNT] = {"plans", "facilities", "actions", "settlements", "catalog", "backup"};
+
+void Memory::allocated(Category category, long long bytes, long long objects)
+{
+    Account &account = accounts[category];
+    long long live = account.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    account.objects.fetch_add(objects, std::memory_order_relaxed);
+    long long peak = account.peak.load(std::memory_order_relaxed);
+    while (live > peak && !account.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Memory::released(Category category, long long bytes, long long objects)
+{
+    accounts[category].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    accounts[category].objects.fetch_sub(objects, std::memory_order_relaxed);
+}
+
+// backups are per thread, so each thread takes only its own backup's bytes out of the account
+static thread_local long long threadBackup = 0;
+
+void Memory::setBackup(long long bytes)
+{
+    if (threadBackup > 0)
+    {
+        released(BACKUP, threadBackup);
+    }
+    threadBackup = bytes > 0 ? bytes : 0;
+    if (threadBackup > 0)
+    {
+        allocated(BACKUP, threadBackup);
+    }
+}
+
+long long Memory::backupBytes()
+{
+    return threadBackup;
+}
+
+long long Memory::liveBytes()
+{
+    long long total = 0;
+    for (int i = 0; i < CATEGORY_COUNT; i++)
+    {
+        if (i != BACKUP)
+        {
+            total += liveBytes(static_cast<Category>(i));
+        }
+    }
+    return total;
+}
+
+long long Memory::liveBytes(Category category)
+{
+    return accounts[category].bytes.load(std::memory_order_relaxed);
+}
+
+long long Memory::averageObjectBytes(Category category)
+{
+    long long objects = accounts[category].objects.load(std::memory_order_relaxed);
+    return objects > 0 ? liveBytes(category) / objects : 0;
+}
+
+void Memory::setSoftLimit(long long bytes)
+{
+    softLimit.store(bytes, std::memory_order_relaxed);
+}
+
+bool Memory::wouldExceedSoftLimit(long long extraBytes)
+{
+    long long limit = softLimit.load(std::memory_order_relaxed);
+    return limit > 0 && liveBytes() + extraBytes > limit;
+}
+
+void Memory::print(std::ostream &out)
+{
+    out << "Category LiveBytes Objects PeakBytes" << endl;
+    for (int i = 0; i < CATEGORY_COUNT; i++)
+    {
+        const Account &account = accounts[i];
+        out << CATEGORY_NAMES[i] << " " << account.bytes.load(std::memory_order_relaxed) << " " << account.objects.load(std::memory_order_relaxed)
+            << " " << account.peak.load(std::memory_order_relaxed) << endl;
+    }
+    out << "Total: " << liveBytes();
+    long long limit = softLimit.load(std::memory_order_relaxed);
+    if (limit > 0)
+    {
+        out << " of " << limit << " soft limit";
+    }
+    out << " (backup already counted in the categories)" << endl;
+}
@@ -1,27 +1,24 @@
 #include "Plan.h"
 #include "SelectionPolicy.h"
-#include <sstream>
+#include "Trace.h"
+#include "ReportWriter.h"
 #include <iostream>
-#include <algorithm>
+#include <chrono>
 
 using namespace std;
 
 // constructor
-Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions) : plan_id(planId), settlement(settlement), selectionPolicy(selectionPolicy), status(PlanStatus::AVALIABLE), facilities(), underConstruction(), facilityOptions(facilityOptions), life_quality_score(0), economy_score(0), environment_score(0)
+Plan::Plan() : plan_id(-1), settlementIndex(-1), lastSelectedIndex(-1), status(PlanStatus::AVALIABLE), policy(SelectionPolicyKind::NAIVE), capacity(0), underConstructionCount(0), constructionTimers(), underConstruction(), life_quality_score(0), economy_score(0), environment_score(0), facilitiesTail(-1), facilitiesCount(0)
 {
 }
 
-Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, PlanStatus status, vector<Facility *> newFacilities, vector<Facility *> newUnderConstruction, const vector<FacilityType> &facilityOptions, int life_quality_score, int economy_score, int environment_score) : plan_id(planId), settlement(settlement), selectionPolicy(selectionPolicy), status(status), facilities(), underConstruction(), facilityOptions(facilityOptions), life_quality_score(life_quality_score), economy_score(economy_score), environment_score(environment_score)
+Plan::Plan(const int planId, int settlementIndex, const Settlement &settlement, SelectionPolicy *selectionPolicy) : plan_id(planId), settlementIndex(settlementIndex), lastSelectedIndex(-1), status(PlanStatus::AVALIABLE), policy(SelectionPolicyKind::NAIVE), capacity(settlement.facilitiesNum()), underConstructionCount(0), constructionTimers(), underConstruction(), life_quality_score(0), economy_score(0), environment_score(0), facilitiesTail(-1), facilitiesCount(0)
 {
-    for (Facility *facility : newFacilities)
-    {
-        facilities.push_back(new Facility(*facility));
-    }
+    setSelectionPolicy(selectionPolicy);
+}
 
-    for (Facility *facility : newUnderConstruction)
-    {
-        underConstruction.push_back(new Facility(*facility));
-    }
+Plan::Plan(const int planId, int settlementIndex, const Settlement &settlement, SelectionPolicyKind policy) : plan_id(planId), settlementIndex(settlementIndex), lastSelectedIndex(-1), status(PlanStatus::AVALIABLE), policy(policy), capacity(settlement.facilitiesNum()), underConstructionCount(0), constructionTimers(), underConstruction(), life_quality_score(0), economy_score(0), environment_score(0), facilitiesTail(-1), facilitiesCount(0)
+{
 }
 
 const int Plan::getID() const
@@ -51,57 +48,179 @@ const PlanStatus Plan::getStatus() const
 
 void Plan::setSelectionPolicy(SelectionPolicy *newSelectionPolicy)
 {
-    if (typeid(*newSelectionPolicy) == typeid(BalancedSelection))
+    policy = newSelectionPolicy->getKind();
+    switch (policy)
+    {
+    case SelectionPolicyKind::NAIVE:
+        lastSelectedIndex = static_cast<NaiveSelection *>(newSelectionPolicy)->getLastSelectedIndex();
+        break;
+    case SelectionPolicyKind::ECONOMY:
+        lastSelectedIndex = static_cast<EconomySelection *>(newSelectionPolicy)->getLastSelectedIndex();
+        break;
+    case SelectionPolicyKind::SUSTAINABILITY:
+        lastSelectedIndex = static_cast<SustainabilitySelection *>(newSelectionPolicy)->getLastSelectedIndex();
+        break;
+    default:
+        // balanced selection always starts from the scores plus what is being built
+        lastSelectedIndex = -1;
+        break;
+    }
+    delete newSelectionPolicy;
+}
+
+SelectionPolicyKind Plan::getPolicyKind() const
+{
+    return policy;
+}
+
+const string Plan::getSelectionPolicyName() const
+{
+    switch (policy)
+    {
+    case SelectionPolicyKind::NAIVE:
+        return "Naive";
+    case SelectionPolicyKind::BALANCED:
+        return "Balanced";
+    case SelectionPolicyKind::ECONOMY:
+        return "Economy";
+    default:
+        return "Sustainability";
+    }
+}
+
+int Plan::selectFacility(const FacilityCatalog &facilityOptions, Stats::Block &stats)
+{
+    stats.add(static_cast<Stats::Counter>(Stats::SELECTIONS + static_cast<int>(policy)));
+    int previous = lastSelectedIndex;
+    int selected;
+    switch (policy)
+    {
+    case SelectionPolicyKind::NAIVE:
+        selected = NaiveSelection::select(facilityOptions, lastSelectedIndex);
+        break;
+    case SelectionPolicyKind::ECONOMY:
+        selected = EconomySelection::select(facilityOptions, lastSelectedIndex);
+        break;
+    case SelectionPolicyKind::SUSTAINABILITY:
+        selected = SustainabilitySelection::select(facilityOptions, lastSelectedIndex);
+        break;
+    default:
     {
         int life = life_quality_score;
         int eco = economy_score;
         int env = environment_score;
-
-        for (int i = 0; i < (int)underConstruction.size(); i++)
+        for (int i = 0; i < underConstructionCount; i++)
         {
-            life += underConstruction[i]->getLifeQualityScore();
-            eco += underConstruction[i]->getEconomyScore();
-            env += underConstruction[i]->getEnvironmentScore();
+            const FacilityStats &facility = facilityOptions[underConstruction[i]];
+            life += facility.getLifeQualityScore();
+            eco += facility.getEconomyScore();
+            env += facility.getEnvironmentScore();
         }
+        stats.add(Stats::CATALOG_SCANNED, facilityOptions.size());
+        return BalancedSelection::select(facilityOptions, life, eco, env);
+    }
+    }
+    // the cyclic policies scan forward from just after their last choice
+    int scanned = selected - previous;
+    stats.add(Stats::CATALOG_SCANNED, scanned > 0 ? scanned : scanned + facilityOptions.size());
+    return selected;
+}
 
-        (static_cast<BalancedSelection *>(newSelectionPolicy))->setFields(life, eco, env);
+void Plan::step(PlanWorld &world)
+{
+    Stats::Block &stats = *world.stats;
+    stats.add(Stats::PLAN_STEPS);
+    if (!stats.sampleStep())
+    {
+        advance<false>(world);
+        return;
     }
-    delete selectionPolicy;
-    this->selectionPolicy = newSelectionPolicy;
+    // the sampled steps are also the ones traced, so big worlds do not flood the trace
+    auto start = std::chrono::steady_clock::now();
+    advance<true>(world);
+    stats.recordStep(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
 }
 
-void Plan::step()
+template <bool Traced>
+void Plan::advance(PlanWorld &world)
 {
+    // the settlement type fixes how many slots there are, let each size get its own loop
+    switch (capacity)
+    {
+    case 1:
+        stepWithCapacity<1, Traced>(world);
+        break;
+    case 2:
+        stepWithCapacity<2, Traced>(world);
+        break;
+    default:
+        stepWithCapacity<3, Traced>(world);
+        break;
+    }
+}
+
+template <int Capacity, bool Traced>
+void Plan::stepWithCapacity(PlanWorld &world)
+{
+    const FacilityCatalog &facilityOptions = *world.facilityOptions;
     if (status == PlanStatus::AVALIABLE)
     {
-        int facilitiesToBuild = settlement.facilitiesNum() - underConstruction.size();
-        for (int i = 1; i <= facilitiesToBuild; i++)
+        Trace::Span span(Traced ? "select" : nullptr, "plan", plan_id);
+        world.stats->add(Stats::FACILITIES_STARTED, Capacity - underConstructionCount);
+        for (; underConstructionCount < Capacity; underConstructionCount++)
         {
-            Facility *currFacility = new Facility(selectionPolicy->selectFacility(facilityOptions), settlement.getName());
-            underConstruction.push_back(currFacility);
+            int selected = selectFacility(facilityOptions, *world.stats);
+            constructionTimers[underConstructionCount] = facilityOptions[selected].getCost();
+            underConstruction[underConstructionCount] = selected;
+            if (world.events != nullptr)
+            {
+                world.events->push_back(PlanEvent{PlanEventKind::FACILITY_STARTED, 0, plan_id, selected, 0, 0, 0});
+            }
         }
     }
-    for (int i = 0; i < (int)underConstruction.size(); i++)
+
+    // one pass over the packed timers, then move the finished facilities in their original order
+    Trace::Span span(Traced ? "construct" : nullptr, "plan", plan_id);
+    unsigned completed = Facility::countdown(constructionTimers, underConstructionCount);
+    if (completed != 0)
     {
-        (underConstruction[i])->step();
-        if (underConstruction[i]->getStatus() == FacilityStatus::OPERATIONAL)
+        int kept = 0;
+        for (int i = 0; i < underConstructionCount; i++)
         {
-            facilities.push_back(underConstruction[i]);
-            life_quality_score += underConstruction[i]->getLifeQualityScore();
-            economy_score += underConstruction[i]->getEconomyScore();
-            environment_score += underConstruction[i]->getEnvironmentScore();
-            underConstruction.erase(underConstruction.begin() + i);
-            i--;
+            int facility = underConstruction[i];
+            if (completed & (1u << i))
+            {
+                facilitiesTail = world.facilities->append(facilitiesTail, facilitiesCount, facility);
+                facilitiesCount++;
+                const FacilityStats &type = facilityOptions[facility];
+                life_quality_score += type.getLifeQualityScore();
+                economy_score += type.getEconomyScore();
+                environment_score += type.getEnvironmentScore();
+                if (world.events != nullptr)
+                {
+                    world.events->push_back(PlanEvent{PlanEventKind::FACILITY_COMPLETED, 0, plan_id, facility, type.getLifeQualityScore(), type.getEconomyScore(), type.getEnvironmentScore()});
+                }
+            }
+            else
+            {
+                underConstruction[kept] = facility;
+                constructionTimers[kept] = constructionTimers[i];
+                kept++;
+            }
         }
+        world.stats->add(Stats::FACILITIES_COMPLETED, underConstructionCount - kept);
+        underConstructionCount = kept;
     }
-
-    if ((int)underConstruction.size() >= settlement.facilitiesNum())
+    if (world.changed != nullptr && (completed != 0 || status == PlanStatus::AVALIABLE))
     {
-        status = PlanStatus::BUSY;
+        world.changed->note(plan_id);
     }
-    else
+
+    PlanStatus previous = status;
+    status = underConstructionCount >= Capacity ? PlanStatus::BUSY : PlanStatus::AVALIABLE;
+    if (world.events != nullptr && previous == PlanStatus::AVALIABLE && status == PlanStatus::BUSY)
     {
-        status = PlanStatus::AVALIABLE;
+        world.events->push_back(PlanEvent{PlanEventKind::PLAN_BUSY, 0, plan_id, -1, 0, 0, 0});
     }
 }
 
@@ -123,186 +242,72 @@ void Plan::printStatus()
     cout << statusToString(status) << endl;
 }
 
-const string Plan::toString() const
+const string Plan::toString(const PlanWorld &world) const
 {
-    std::ostringstream oss;
-    oss << "PlanID: " << this->getID() << "\n";
-    oss << "SettlementName: " << this->settlement.getName() << "\n";
-    oss << "PlanStatus: " << statusToString(this->status) << "\n";
-    string sp = "";
-    if (typeid(*this->selectionPolicy) == typeid(NaiveSelection))
-    {
-        sp = "nve";
-    }
-    else if (typeid(*this->selectionPolicy) == typeid(BalancedSelection))
-    {
-        sp = "bal";
-    }
-    else if (typeid(*this->selectionPolicy) == typeid(EconomySelection))
-    {
-        sp = "eco";
-    }
-    else if (typeid(*this->selectionPolicy) == typeid(SustainabilitySelection))
-    {
-        sp = "env";
-    }
-    oss << "SelectionPolicy: " << sp << "\n";
-    oss << "LifeQualityScore: " << this->getlifeQualityScore() << "\n";
-    oss << "EconomyScore: " << this->getEconomyScore() << "\n";
-    oss << "EnvironmentScore: " << this->getEnvironmentScore() << "\n";
-
-    for (Facility *fac : this->facilities)
-    {
-        oss << "FacilityName: " << fac->getName() << "\n";
-        oss << "FacilityStatus: OPERATIONAL" << "\n";
-    }
-
-    for (Facility *uc : this->underConstruction)
-    {
-        oss << "FacilityName: " << uc->getName() << "\n";
-        oss << "FacilityStatus: UNDER_CONSTRUCTIONS" << "\n";
-    }
-
-    return oss.str();
+    ReportWriter report;
+    report.planStatus(*this, world);
+    return report.take();
 }
 
-const Settlement Plan::getSettlement() const
+int Plan::getSettlementIndex() const
 {
-    return settlement;
+    return settlementIndex;
 }
 
-const SelectionPolicy *Plan::getSelectionPolicy() const
+const Settlement &Plan::getSettlement(const PlanWorld &world) const
 {
-    return selectionPolicy;
+    return *(*world.settlements)[settlementIndex];
 }
 
-const vector<Facility *> &Plan::getFacilities() const
+vector<int> Plan::getFacilities(const PlanWorld &world) const
 {
+    vector<int> facilities;
+    readFacilities(world, facilities);
     return facilities;
 }
-const vector<Facility *> &Plan::getunderConstruction() const
-{
-    return underConstruction;
-}
-void Plan::addFacility(Facility *facility)
+
+void Plan::readFacilities(const PlanWorld &world, vector<int> &facilities) const
 {
-    facilities.push_back(facility);
+    world.facilities->read(facilitiesTail, facilitiesCount, facilities);
 }
-// Rule of 5
-///////////////////////////////////////
 
-void Plan::clear()
+void Plan::readFacilitiesSince(const PlanWorld &world, int first, vector<int> &facilities) const
 {
-    for (Facility *facility : facilities)
-    {
-        delete facility;
-    }
-    facilities.clear();
-
-    for (Facility *facility : underConstruction)
-    {
-        delete facility;
-    }
-    underConstruction.clear();
-
-    if (selectionPolicy)
-    {
-        delete selectionPolicy;
-        selectionPolicy = nullptr;
-    }
+    world.facilities->readFrom(facilitiesTail, facilitiesCount, first, facilities);
 }
 
-void Plan::copy(const Plan &other)
+PlanCursor Plan::getCursor(int generation) const
 {
-    selectionPolicy = other.selectionPolicy->clone();
-
-    for (Facility *facility : other.facilities)
-    {
-        facilities.push_back(new Facility(*facility));
-    }
-
-    for (Facility *facility : other.underConstruction)
-    {
-        underConstruction.push_back(new Facility(*facility));
-    }
+    PlanCursor cursor = {generation, facilitiesCount, facilitiesCount + underConstructionCount};
+    return cursor;
 }
 
-Plan::Plan(const Plan &other)
-    : plan_id(other.plan_id),
-      settlement(other.settlement),
-      selectionPolicy(nullptr),
-      status(other.status),
-      facilities(),
-      underConstruction(),
-      facilityOptions(other.facilityOptions),
-      life_quality_score(other.life_quality_score),
-      economy_score(other.economy_score),
-      environment_score(other.environment_score)
+int Plan::getFacilitiesCount() const
 {
-    copy(other);
+    return facilitiesCount;
 }
 
-Plan &Plan::operator=(const Plan &other)
+int Plan::getUnderConstruction(int slot) const
 {
-    if (this != &other)
-    {
-        // Clean up existing resources
-        clear();
-
-        // copy fields
-        plan_id = other.plan_id;
-        status = other.status;
-        life_quality_score = other.life_quality_score;
-        economy_score = other.economy_score;
-        environment_score = other.environment_score;
-        copy(other);
-
-        // settlement and facilityOptions are const references, no reassignment needed
-    }
-    return *this;
+    return underConstruction[slot];
 }
 
-Plan::~Plan()
+int Plan::getUnderConstructionCount() const
 {
-    clear();
+    return underConstructionCount;
 }
 
-Plan::Plan(Plan &&other) : plan_id(other.plan_id),
-                           settlement(other.settlement),
-                           selectionPolicy(other.selectionPolicy),
-                           status(other.status),
-                           facilities(other.facilities),
-                           underConstruction(other.underConstruction),
-                           facilityOptions(other.facilityOptions),
-                           life_quality_score(other.life_quality_score),
-                           economy_score(other.economy_score),
-                           environment_score(other.environment_score)
+void Plan::mirror(const Plan &representative)
 {
-    other.selectionPolicy = nullptr;
-    other.facilities.clear();
-    other.underConstruction.clear();
+    // everything but who the plan is; the finished facilities are shared until the plan detaches
+    int id = plan_id;
+    int settlement = settlementIndex;
+    *this = representative;
+    plan_id = id;
+    settlementIndex = settlement;
 }
 
-Plan &Plan::operator=(Plan &&other)
+void Plan::copyFacilities(const PlanWorld &from, PlanWorld &to)
 {
-    if (this != &other)
-    {
-        // Clean up existing resources
-        clear();
-
-        // copy fields
-        plan_id = other.plan_id;
-        status = other.status;
-        life_quality_score = other.life_quality_score;
-        economy_score = other.economy_score;
-        environment_score = other.environment_score;
-        facilities = other.facilities;
-        underConstruction = other.underConstruction;
-        selectionPolicy = other.selectionPolicy;
-
-        other.selectionPolicy = nullptr;
-        other.facilities.clear();
-        other.underConstruction.clear();
-    }
-    return *this;
-}
\ No newline at end of file
+    facilitiesTail = from.facilities->copyList(facilitiesTail, facilitiesCount, *to.facilities);
+}
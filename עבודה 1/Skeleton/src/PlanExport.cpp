@@ -0,0 +1,262 @@
+#include "PlanExport.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+static const unsigned NO_DICTIONARY = 0xffffffffu;
+static const int HEADER_BYTES = 32;
+static const int ENTRY_BYTES = 48;
+static const int NAME_BYTES = 24;
+
+namespace
+{
+    // One thread writes every export, in the order they were started. It is started by the first
+    // export and finishes the queue when the process exits, whether or not waitAll was called.
+    class Writer
+    {
+    public:
+        static Writer &instance()
+        {
+            static Writer writer;
+            return writer;
+        }
+
+        Writer(const Writer &other) = delete;
+        Writer &operator=(const Writer &other) = delete;
+
+        ~Writer()
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+
+        void submit(const string &path, const std::function<bool()> &job)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!thread.joinable())
+            {
+                thread = std::thread(&Writer::run, this);
+            }
+            queue.push_back(std::make_pair(path, job));
+            wake.notify_all();
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this]
+                      { return queue.empty() && !busy; });
+        }
+
+        bool takeFailure(string &path)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (failures.empty())
+            {
+                return false;
+            }
+            path = failures.front();
+            failures.pop_front();
+            return true;
+        }
+
+    private:
+        Writer() : lock(), wake(), queue(), failures(), busy(false), stopping(false), thread() {}
+
+        void run()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while (true)
+            {
+                wake.wait(guard, [this]
+                          { return !queue.empty() || stopping; });
+                if (queue.empty())
+                {
+                    return;
+                }
+                std::pair<string, std::function<bool()>> job = queue.front();
+                queue.pop_front();
+                busy = true;
+                guard.unlock();
+                bool written = job.second();
+                guard.lock();
+                busy = false;
+                if (!written)
+                {
+                    failures.push_back(job.first);
+                }
+                wake.notify_all();
+            }
+        }
+
+        std::mutex lock;
+        std::condition_variable wake; // a job was queued or finished, or the process is exiting
+        std::deque<std::pair<string, std::function<bool()>>> queue;
+        std::deque<string> failures; // paths whose write failed, not reported yet
+        bool busy;
+        bool stopping;
+        std::thread thread;
+    };
+
+    struct Column
+    {
+        const char *name;
+        unsigned type;
+        unsigned dictionary;
+        string data;
+    };
+
+    template <typename T>
+    void append(string &out, T value) // little-endian, whatever the host
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            out.push_back(static_cast<char>(static_cast<unsigned long long>(value) >> (8 * i)));
+        }
+    }
+
+    Column intColumn(const char *name, const vector<int> &values, unsigned dictionary = NO_DICTIONARY)
+    {
+        Column column = {name, PlanExport::INT32, dictionary, string()};
+        column.data.reserve(values.size() * 4);
+        for (int value : values)
+        {
+            append(column.data, static_cast<unsigned>(value));
+        }
+        return column;
+    }
+
+    Column byteColumn(const char *name, const vector<unsigned char> &values, unsigned dictionary = NO_DICTIONARY)
+    {
+        Column column = {name, PlanExport::UINT8, dictionary, string(values.begin(), values.end())};
+        return column;
+    }
+
+    Column dictionaryColumn(const char *name, const vector<string> &strings)
+    {
+        Column column = {name, PlanExport::DICTIONARY, NO_DICTIONARY, string()};
+        append(column.data, static_cast<unsigned>(strings.size()));
+        unsigned offset = 0;
+        append(column.data, offset);
+        for (const string &text : strings)
+        {
+            offset += text.size();
+            append(column.data, offset);
+        }
+        for (const string &text : strings)
+        {
+            column.data += text;
+        }
+        return column;
+    }
+}
+
+bool PlanExport::start(Simulation &simulation, const string &path)
+{
+    std::shared_ptr<std::ofstream> file = std::make_shared<std::ofstream>(path, std::ios::binary);
+    if (!*file)
+    {
+        return false;
+    }
+
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    int count = simulation.getPlanCount();
+    snapshot->tick = simulation.getTick();
+    snapshot->planIds.reserve(count);
+    snapshot->settlements.reserve(count);
+    snapshot->policies.reserve(count);
+    snapshot->lifeQualityScores.reserve(count);
+    snapshot->economyScores.reserve(count);
+    snapshot->environmentScores.reserve(count);
+    snapshot->statuses.reserve(count);
+    snapshot->operational.reserve(count);
+    snapshot->inProgress.reserve(count);
+    for (const Plan &plan : simulation.planStates())
+    {
+        snapshot->planIds.push_back(plan.getID());
+        snapshot->settlements.push_back(plan.getSettlementIndex());
+        snapshot->policies.push_back(static_cast<unsigned char>(plan.getPolicyKind()));
+        snapshot->lifeQualityScores.push_back(plan.getlifeQualityScore());
+        snapshot->economyScores.push_back(plan.getEconomyScore());
+        snapshot->environmentScores.push_back(plan.getEnvironmentScore());
+        snapshot->statuses.push_back(static_cast<unsigned char>(plan.getStatus()));
+        snapshot->operational.push_back(plan.getFacilitiesCount());
+        snapshot->inProgress.push_back(static_cast<unsigned char>(plan.getUnderConstructionCount()));
+    }
+    PlanWorld world = simulation.getWorld();
+    for (const Settlement *settlement : *world.settlements)
+    {
+        snapshot->settlementNames.push_back(settlement->getName());
+    }
+
+    Writer::instance().submit(path, [file, snapshot]
+                              { return write(*file, *snapshot); });
+    return true;
+}
+
+void PlanExport::waitAll()
+{
+    Writer::instance().wait();
+}
+
+bool PlanExport::takeFailure(string &path)
+{
+    return Writer::instance().takeFailure(path);
+}
+
+bool PlanExport::write(std::ofstream &file, const Snapshot &snapshot)
+{
+    // the dictionaries go first so the columns coded against them can name their index
+    vector<Column> columns;
+    columns.push_back(dictionaryColumn("settlement_names", snapshot.settlementNames));
+    columns.push_back(dictionaryColumn("policy_names", {"nve", "bal", "eco", "env"}));
+    columns.push_back(dictionaryColumn("status_names", {"AVALIABLE", "BUSY"}));
+    columns.push_back(intColumn("plan_id", snapshot.planIds));
+    columns.push_back(intColumn("settlement", snapshot.settlements, 0));
+    columns.push_back(byteColumn("policy", snapshot.policies, 1));
+    columns.push_back(intColumn("life_quality", snapshot.lifeQualityScores));
+    columns.push_back(intColumn("economy", snapshot.economyScores));
+    columns.push_back(intColumn("environment", snapshot.environmentScores));
+    columns.push_back(byteColumn("status", snapshot.statuses, 2));
+    columns.push_back(intColumn("operational", snapshot.operational));
+    columns.push_back(byteColumn("in_progress", snapshot.inProgress));
+
+    string header("PLANCOL1");
+    append(header, 1u);
+    append(header, static_cast<unsigned>(columns.size()));
+    append(header, static_cast<unsigned long long>(snapshot.planIds.size()));
+    append(header, static_cast<unsigned long long>(snapshot.tick));
+    unsigned long long offset = HEADER_BYTES + ENTRY_BYTES * columns.size();
+    for (const Column &column : columns)
+    {
+        char name[NAME_BYTES] = {};
+        strncpy(name, column.name, NAME_BYTES - 1);
+        header.append(name, NAME_BYTES);
+        append(header, column.type);
+        append(header, column.dictionary);
+        append(header, offset);
+        append(header, static_cast<unsigned long long>(column.data.size()));
+        offset += (column.data.size() + 7) / 8 * 8;
+    }
+    file.write(header.data(), header.size());
+    for (const Column &column : columns)
+    {
+        file.write(column.data.data(), column.data.size());
+        file.write("\0\0\0\0\0\0\0", (8 - column.data.size() % 8) % 8);
+    }
+    file.close();
+    return !file.fail();
+}
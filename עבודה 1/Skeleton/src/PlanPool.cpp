@@ -0,0 +1,119 @@
+#include "PlanPool.h"
+#include "Memory.h"
+#include <algorithm>
+
+using namespace std;
+
+PlanPool::PlanPool() : chunks(), count(0)
+{
+}
+
+void PlanPool::push_back(const Plan &plan)
+{
+    if (count == static_cast<int>(chunks.size()) * CHUNK_PLANS)
+    {
+        chunks.push_back(new Plan[CHUNK_PLANS]);
+        Memory::allocated(Memory::PLANS, sizeof(Plan) * CHUNK_PLANS, 0);
+    }
+    (*this)[count] = plan;
+    count++;
+    Memory::allocated(Memory::PLANS, 0);
+}
+
+void PlanPool::reserve(int plans)
+{
+    int reserved = 0;
+    while (static_cast<int>(chunks.size()) * CHUNK_PLANS < plans)
+    {
+        chunks.push_back(new Plan[CHUNK_PLANS]);
+        reserved++;
+    }
+    Memory::allocated(Memory::PLANS, sizeof(Plan) * CHUNK_PLANS * reserved, 0);
+}
+
+Plan &PlanPool::operator[](int index)
+{
+    return chunks[index >> CHUNK_SHIFT][index & (CHUNK_PLANS - 1)];
+}
+
+const Plan &PlanPool::operator[](int index) const
+{
+    return chunks[index >> CHUNK_SHIFT][index & (CHUNK_PLANS - 1)];
+}
+
+int PlanPool::size() const
+{
+    return count;
+}
+
+long long PlanPool::memoryBytes() const
+{
+    return static_cast<long long>(sizeof(Plan)) * CHUNK_PLANS * chunks.size();
+}
+
+// Rule of 5
+///////////////////////////////////////
+
+void PlanPool::clear()
+{
+    for (Plan *chunk : chunks)
+    {
+        delete[] chunk;
+    }
+    Memory::released(Memory::PLANS, sizeof(Plan) * CHUNK_PLANS * chunks.size(), count);
+    chunks.clear();
+    count = 0;
+}
+
+void PlanPool::copy(const PlanPool &other)
+{
+    // chunks reserved but not reached yet stay behind
+    for (int first = 0; first < other.count; first += CHUNK_PLANS)
+    {
+        const Plan *chunk = other.chunks[first >> CHUNK_SHIFT];
+        Plan *copied = new Plan[CHUNK_PLANS];
+        std::copy(chunk, chunk + CHUNK_PLANS, copied);
+        chunks.push_back(copied);
+    }
+    count = other.count;
+    Memory::allocated(Memory::PLANS, sizeof(Plan) * CHUNK_PLANS * chunks.size(), count);
+}
+
+PlanPool::PlanPool(const PlanPool &other) : chunks(), count(0)
+{
+    copy(other);
+}
+
+PlanPool &PlanPool::operator=(const PlanPool &other)
+{
+    if (this != &other)
+    {
+        clear();
+        copy(other);
+    }
+    return *this;
+}
+
+PlanPool::~PlanPool()
+{
+    clear();
+}
+
+PlanPool::PlanPool(PlanPool &&other) : chunks(std::move(other.chunks)), count(other.count)
+{
+    other.chunks.clear();
+    other.count = 0;
+}
+
+PlanPool &PlanPool::operator=(PlanPool &&other)
+{
+    if (this != &other)
+    {
+        clear();
+        chunks = std::move(other.chunks);
+        count = other.count;
+        other.chunks.clear();
+        other.count = 0;
+    }
+    return *this;
+}
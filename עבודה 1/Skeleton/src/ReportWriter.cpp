@@ -0,0 +1,203 @@
+#include "ReportWriter.h"
+
+using namespace std;
+
+ReportWriter::ReportWriter() : out(nullptr), buffer(), facilities(), settlementFragments(), facilityFragments()
+{
+}
+
+ReportWriter::ReportWriter(std::ostream &out) : out(&out), buffer(), facilities(), settlementFragments(), facilityFragments()
+{
+    buffer.reserve(FLUSH_BYTES + 4096);
+}
+
+ReportWriter::~ReportWriter()
+{
+    flush();
+}
+
+void ReportWriter::planSummary(const Plan &plan, const PlanWorld &world)
+{
+    append("Plan ID: ");
+    appendInt(plan.getID());
+    append("\n");
+    settlementFragment(world, plan.getSettlementIndex());
+    append("Life Quality Score: ");
+    appendInt(plan.getlifeQualityScore());
+    append("\nEconomy Score: ");
+    appendInt(plan.getEconomyScore());
+    append("\nEnvironment Score: ");
+    appendInt(plan.getEnvironmentScore());
+    append("\n");
+    maybeFlush();
+}
+
+void ReportWriter::planStatus(const Plan &plan, const PlanWorld &world)
+{
+    append("PlanID: ");
+    appendInt(plan.getID());
+    append("\nSettlementName: ");
+    append(plan.getSettlement(world).getName());
+    append("\n");
+    appendState(plan);
+    appendScores(plan);
+    appendFacilities(plan, world, 0);
+}
+
+void ReportWriter::planChanges(const Plan &plan, const PlanWorld &world, const PlanCursor &seen, const PlanCursor &now)
+{
+    append("PlanID: ");
+    appendInt(plan.getID());
+    append("\nCursor: ");
+    appendInt(now.generation);
+    append(":");
+    appendInt(now.completed);
+    append(":");
+    appendInt(now.started);
+    append("\n");
+    bool current = seen.generation == now.generation;
+    int completed = current ? seen.completed : 0;
+    if (current && seen.started == now.started && seen.completed == now.completed)
+    {
+        return;
+    }
+    appendState(plan);
+    if (!current || completed != now.completed)
+    {
+        appendScores(plan);
+    }
+    appendFacilities(plan, world, completed);
+}
+
+void ReportWriter::appendFacilities(const Plan &plan, const PlanWorld &world, int firstCompleted)
+{
+    plan.readFacilitiesSince(world, firstCompleted, facilities);
+    for (int facility : facilities)
+    {
+        facilityFragment(world, facility, true);
+        maybeFlush();
+    }
+    for (int i = 0; i < plan.getUnderConstructionCount(); i++)
+    {
+        facilityFragment(world, plan.getUnderConstruction(i), false);
+    }
+    maybeFlush();
+}
+
+void ReportWriter::appendState(const Plan &plan)
+{
+    append(plan.getStatus() == PlanStatus::BUSY ? "PlanStatus: BUSY\n" : "PlanStatus: AVALIABLE\n");
+    switch (plan.getPolicyKind())
+    {
+    case SelectionPolicyKind::NAIVE:
+        append("SelectionPolicy: nve\n");
+        break;
+    case SelectionPolicyKind::BALANCED:
+        append("SelectionPolicy: bal\n");
+        break;
+    case SelectionPolicyKind::ECONOMY:
+        append("SelectionPolicy: eco\n");
+        break;
+    case SelectionPolicyKind::SUSTAINABILITY:
+        append("SelectionPolicy: env\n");
+        break;
+    }
+}
+
+void ReportWriter::appendScores(const Plan &plan)
+{
+    append("LifeQualityScore: ");
+    appendInt(plan.getlifeQualityScore());
+    append("\nEconomyScore: ");
+    appendInt(plan.getEconomyScore());
+    append("\nEnvironmentScore: ");
+    appendInt(plan.getEnvironmentScore());
+    append("\n");
+}
+
+void ReportWriter::endReport()
+{
+    append("\n");
+    maybeFlush();
+}
+
+void ReportWriter::flush()
+{
+    if (out != nullptr && !buffer.empty())
+    {
+        out->write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+string ReportWriter::take()
+{
+    string report;
+    report.swap(buffer);
+    return report;
+}
+
+void ReportWriter::append(const char *text, size_t length)
+{
+    buffer.append(text, length);
+}
+
+void ReportWriter::append(const string &text)
+{
+    buffer.append(text);
+}
+
+void ReportWriter::appendInt(int value)
+{
+    char digits[12];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+    unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+    do
+    {
+        *--start = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+    {
+        *--start = '-';
+    }
+    buffer.append(start, end - start);
+}
+
+void ReportWriter::settlementFragment(const PlanWorld &world, int settlementIndex)
+{
+    if (settlementIndex >= static_cast<int>(settlementFragments.size()))
+    {
+        settlementFragments.resize(world.settlements->size());
+    }
+    string &fragment = settlementFragments[settlementIndex];
+    if (fragment.empty())
+    {
+        fragment = "Settlement Name: " + (*world.settlements)[settlementIndex]->getName() + "\n";
+    }
+    append(fragment);
+}
+
+void ReportWriter::facilityFragment(const PlanWorld &world, int facility, bool operational)
+{
+    int slot = 2 * facility + (operational ? 0 : 1);
+    if (slot >= static_cast<int>(facilityFragments.size()))
+    {
+        facilityFragments.resize(2 * world.facilityOptions->size());
+    }
+    string &fragment = facilityFragments[slot];
+    if (fragment.empty())
+    {
+        fragment = "FacilityName: " + world.facilityOptions->getName(facility) + (operational ? "\nFacilityStatus: OPERATIONAL\n" : "\nFacilityStatus: UNDER_CONSTRUCTIONS\n");
+    }
+    append(fragment);
+}
+
+void ReportWriter::maybeFlush()
+{
+    if (out != nullptr && buffer.size() >= FLUSH_BYTES)
+    {
+        flush();
+    }
+}
@@ -1,6 +1,7 @@
 #include "SelectionPolicy.h"
 #include <iostream>
 #include <algorithm>
+#include <limits>
 
 using namespace std;
 
@@ -13,10 +14,25 @@ NaiveSelection::NaiveSelection(const int index) : SelectionPolicy(), lastSelecte
 {
 }
 
-const FacilityType &NaiveSelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+FacilityType NaiveSelection::selectFacility(const FacilityCatalog &facilitiesOptions)
+{
+    return facilitiesOptions.getType(select(facilitiesOptions, lastSelectedIndex));
+}
+
+int NaiveSelection::select(const FacilityCatalog &facilitiesOptions, int &lastSelectedIndex)
 {
     lastSelectedIndex = (lastSelectedIndex + 1) % facilitiesOptions.size(); // modulo
-    return facilitiesOptions[lastSelectedIndex];
+    return lastSelectedIndex;
+}
+
+SelectionPolicyKind NaiveSelection::getKind() const
+{
+    return SelectionPolicyKind::NAIVE;
+}
+
+int NaiveSelection::getLastSelectedIndex() const
+{
+    return lastSelectedIndex;
 }
 
 const string NaiveSelection::toString() const
@@ -40,13 +56,17 @@ SustainabilitySelection::SustainabilitySelection(const int index) : SelectionPol
 {
 }
 
-const FacilityType &SustainabilitySelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+FacilityType SustainabilitySelection::selectFacility(const FacilityCatalog &facilitiesOptions)
 {
+    return facilitiesOptions.getType(select(facilitiesOptions, lastSelectedIndex));
+}
 
+int SustainabilitySelection::select(const FacilityCatalog &facilitiesOptions, int &lastSelectedIndex)
+{
     bool found = false;
     for (int i = lastSelectedIndex + 1; i != lastSelectedIndex && !found; i++)
     {
-        if (i == static_cast<int>(facilitiesOptions.size()))
+        if (i == facilitiesOptions.size())
         {
             i = 0;
         }
@@ -58,8 +78,19 @@ const FacilityType &SustainabilitySelection::selectFacility(const vector<Facilit
         }
     }
 
-    return facilitiesOptions[lastSelectedIndex];
+    return lastSelectedIndex;
+}
+
+SelectionPolicyKind SustainabilitySelection::getKind() const
+{
+    return SelectionPolicyKind::SUSTAINABILITY;
+}
+
+int SustainabilitySelection::getLastSelectedIndex() const
+{
+    return lastSelectedIndex;
 }
+
 const string SustainabilitySelection::toString() const
 {
     return "Sustainability";
@@ -81,7 +112,12 @@ EconomySelection::EconomySelection(const int index) : lastSelectedIndex(index)
 {
 }
 
-const FacilityType &EconomySelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+FacilityType EconomySelection::selectFacility(const FacilityCatalog &facilitiesOptions)
+{
+    return facilitiesOptions.getType(select(facilitiesOptions, lastSelectedIndex));
+}
+
+int EconomySelection::select(const FacilityCatalog &facilitiesOptions, int &lastSelectedIndex)
 {
     lastSelectedIndex++;
     int i = lastSelectedIndex;
@@ -90,7 +126,17 @@ const FacilityType &EconomySelection::selectFacility(const vector<FacilityType>
         i++;
     }
     lastSelectedIndex = i % facilitiesOptions.size();
-    return facilitiesOptions[lastSelectedIndex];
+    return lastSelectedIndex;
+}
+
+SelectionPolicyKind EconomySelection::getKind() const
+{
+    return SelectionPolicyKind::ECONOMY;
+}
+
+int EconomySelection::getLastSelectedIndex() const
+{
+    return lastSelectedIndex;
 }
 
 const string EconomySelection::toString() const
@@ -113,13 +159,19 @@ BalancedSelection::BalancedSelection(int LifeQualityScore, int EconomyScore, int
 }
 
 // select facility
-const FacilityType &BalancedSelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+FacilityType BalancedSelection::selectFacility(const FacilityCatalog &facilitiesOptions)
+{
+    return facilitiesOptions.getType(select(facilitiesOptions, LifeQualityScore, EconomyScore, EnvironmentScore));
+}
+
+int BalancedSelection::select(const FacilityCatalog &facilitiesOptions, int &LifeQualityScore, int &EconomyScore, int &EnvironmentScore)
 {
-    const FacilityType *selectedFacility;
+    int selected = 0;
     int m = std::numeric_limits<int>::max(); // max_value
 
-    for (const FacilityType &ft : facilitiesOptions)
+    for (int i = 0; i < facilitiesOptions.size(); i++)
     {
+        const FacilityStats &ft = facilitiesOptions[i];
         // calculate values
         int tempLifeQualityScore = LifeQualityScore + ft.getLifeQualityScore();
         int tempEconomyScore = EconomyScore + ft.getEconomyScore();
@@ -129,16 +181,22 @@ const FacilityType &BalancedSelection::selectFacility(const vector<FacilityType>
 
         if (d < m)
         {
-            selectedFacility = &ft;
+            selected = i;
             m = d;
         }
     }
 
-    LifeQualityScore += (selectedFacility->getLifeQualityScore());
-    EconomyScore += (selectedFacility->getEconomyScore());
-    EnvironmentScore += (selectedFacility->getEnvironmentScore());
+    const FacilityStats &selectedFacility = facilitiesOptions[selected];
+    LifeQualityScore += selectedFacility.getLifeQualityScore();
+    EconomyScore += selectedFacility.getEconomyScore();
+    EnvironmentScore += selectedFacility.getEnvironmentScore();
+
+    return selected;
+}
 
-    return *selectedFacility;
+SelectionPolicyKind BalancedSelection::getKind() const
+{
+    return SelectionPolicyKind::BALANCED;
 }
 
 // to string
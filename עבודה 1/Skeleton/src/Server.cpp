@@ -0,0 +1,283 @@
+#include "Server.h"
+#include "Action.h"
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+using namespace std;
+
+static const int MAX_EVENTS = 64;
+
+static void setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+Server::Server(Simulation &simulation, const string &socketPath) : simulation(simulation), socketPath(socketPath), listenFd(-1), epollFd(-1), connections()
+{
+}
+
+void Server::open()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+    {
+        throw std::runtime_error("Cannot create socket");
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(listenFd, SOMAXCONN) < 0)
+    {
+        throw std::runtime_error("Cannot listen on: " + socketPath);
+    }
+    setNonBlocking(listenFd);
+
+    epollFd = epoll_create1(0);
+    if (epollFd < 0)
+    {
+        throw std::runtime_error("Cannot create epoll instance");
+    }
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+}
+
+void Server::run()
+{
+    open();
+    simulation.open();
+    cout << "The simulation is listening on " << socketPath << endl;
+
+    epoll_event events[MAX_EVENTS];
+    while (simulation.getIsRunning())
+    {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("epoll_wait failed");
+        }
+
+        // gather the commands of this tick from every ready connection
+        vector<Command> batch;
+        for (int i = 0; i < ready; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == listenFd)
+            {
+                acceptClients();
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                readClient(fd, batch);
+            }
+        }
+
+        runBatch(batch);
+
+        vector<int> finished;
+        for (auto &connection : connections)
+        {
+            if (!flushClient(connection.first) || (connection.second.closing && connection.second.out.empty()))
+            {
+                finished.push_back(connection.first);
+            }
+        }
+        for (int fd : finished)
+        {
+            closeClient(fd);
+        }
+    }
+
+    // the simulation was closed, hand out the last responses before leaving
+    for (auto &connection : connections)
+    {
+        int flags = fcntl(connection.first, F_GETFL, 0);
+        fcntl(connection.first, F_SETFL, flags & ~O_NONBLOCK);
+        flushClient(connection.first);
+    }
+}
+
+void Server::acceptClients()
+{
+    while (true)
+    {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            return;
+        }
+        setNonBlocking(fd);
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        connections[fd] = Connection();
+    }
+}
+
+// reads everything available and queues the complete lines
+void Server::readClient(int fd, vector<Command> &batch)
+{
+    auto it = connections.find(fd);
+    if (it == connections.end())
+    {
+        return;
+    }
+    Connection &connection = it->second;
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0)
+        {
+            connection.in.append(buffer, n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        connection.closing = true;
+        break;
+    }
+
+    size_t start = 0;
+    size_t end;
+    while ((end = connection.in.find('\n', start)) != string::npos)
+    {
+        batch.push_back(Command{fd, connection.in.substr(start, end - start)});
+        start = end + 1;
+    }
+    connection.in.erase(0, start);
+}
+
+void Server::runBatch(const vector<Command> &batch)
+{
+    for (const Command &command : batch)
+    {
+        if (!simulation.getIsRunning())
+        {
+            break;
+        }
+        std::ostringstream response;
+        simulation.setOutput(response);
+        try
+        {
+            BaseAction *action = Simulation::parseAction(command.line);
+            if (action == nullptr)
+            {
+                response << "Command not found" << endl;
+            }
+            else
+            {
+                simulation.execute(action);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // the client hears about it, and the output never outlives the response it points at
+            response << "Command failed: " << e.what() << endl;
+        }
+        simulation.setOutput(cout);
+
+        auto it = connections.find(command.fd);
+        if (it != connections.end())
+        {
+            it->second.out += response.str();
+        }
+    }
+}
+
+// writes as much pending output as the socket takes; returns false if the client is gone
+bool Server::flushClient(int fd)
+{
+    auto it = connections.find(fd);
+    if (it == connections.end())
+    {
+        return false;
+    }
+    Connection &connection = it->second;
+    while (!connection.out.empty())
+    {
+        ssize_t n = send(fd, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (n < 0)
+        {
+            return false;
+        }
+        connection.out.erase(0, n);
+    }
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    if (connection.closing)
+    {
+        event.events = EPOLLOUT;
+    }
+    else
+    {
+        event.events = connection.out.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    }
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    return true;
+}
+
+void Server::closeClient(int fd)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
+
+Server::~Server()
+{
+    for (auto &connection : connections)
+    {
+        close(connection.first);
+    }
+    if (epollFd >= 0)
+    {
+        close(epollFd);
+    }
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+}
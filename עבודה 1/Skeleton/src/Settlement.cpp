@@ -1,4 +1,5 @@
 #include "Settlement.h"
+#include "Memory.h"
 #include <iostream>
 #include <algorithm>
 
@@ -57,3 +58,16 @@ Settlement Settlement::clone() const
 {
     return Settlement(name, type);
 }
+
+void *Settlement::operator new(std::size_t size)
+{
+    void *settlement = ::operator new(size);
+    Memory::allocated(Memory::SETTLEMENTS, size);
+    return settlement;
+}
+
+void Settlement::operator delete(void *settlement, std::size_t size)
+{
+    Memory::released(Memory::SETTLEMENTS, size);
+    ::operator delete(settlement);
+}
@@ -0,0 +1,116 @@
+#include "SettlementAggregates.h"
+
+using namespace std;
+
+SettlementAggregates::SettlementAggregates() : totals(), states(), groups()
+{
+}
+
+void SettlementAggregates::addPlan(int index, int representative, int settlement, const Plan &plan)
+{
+    states.resize(index + 1);
+    groups.resize(index + 1);
+    totalsOf(settlement).plans++;
+    if (representative == index)
+    {
+        states[index] = stateOf(plan);
+        groups[index].push_back(std::make_pair(settlement, 1));
+        add(settlement, states[index], 1);
+        return;
+    }
+
+    // a mirror starts out as whatever its simulated plan last reported
+    vector<std::pair<int, int>> &group = groups[representative];
+    size_t member = 0;
+    while (member < group.size() && group[member].first != settlement)
+    {
+        member++;
+    }
+    if (member == group.size())
+    {
+        group.push_back(std::make_pair(settlement, 0));
+    }
+    group[member].second++;
+    add(settlement, states[representative], 1);
+}
+
+void SettlementAggregates::update(int representative, const Plan &plan)
+{
+    State now = stateOf(plan);
+    State &before = states[representative];
+    State change = {now.life - before.life, now.eco - before.eco, now.env - before.env, now.operational - before.operational, now.underConstruction - before.underConstruction};
+    for (const std::pair<int, int> &member : groups[representative])
+    {
+        add(member.first, change, member.second);
+    }
+    before = now;
+}
+
+void SettlementAggregates::detach(int index, int representative, int settlement, const Plan &plan)
+{
+    // the plan is in step with its simulated plan, so its share of the totals stays as it is
+    vector<std::pair<int, int>> &group = groups[representative];
+    for (size_t member = 0; member < group.size(); member++)
+    {
+        if (group[member].first == settlement)
+        {
+            if (--group[member].second == 0)
+            {
+                group.erase(group.begin() + member);
+            }
+            break;
+        }
+    }
+    groups[index].assign(1, std::make_pair(settlement, 1));
+    states[index] = stateOf(plan);
+}
+
+void SettlementAggregates::handOver(int representative, int settlement, int successor)
+{
+    groups[successor].swap(groups[representative]);
+    groups[representative].assign(1, std::make_pair(settlement, 1));
+    vector<std::pair<int, int>> &group = groups[successor];
+    for (size_t member = 0; member < group.size(); member++)
+    {
+        if (group[member].first == settlement)
+        {
+            if (--group[member].second == 0)
+            {
+                group.erase(group.begin() + member);
+            }
+            break;
+        }
+    }
+    states[successor] = states[representative];
+}
+
+const SettlementAggregates::Totals &SettlementAggregates::get(int settlement)
+{
+    return totalsOf(settlement);
+}
+
+SettlementAggregates::Totals &SettlementAggregates::totalsOf(int settlement)
+{
+    if (settlement >= static_cast<int>(totals.size()))
+    {
+        Totals none = {0, 0, 0, 0, 0, 0};
+        totals.resize(settlement + 1, none);
+    }
+    return totals[settlement];
+}
+
+SettlementAggregates::State SettlementAggregates::stateOf(const Plan &plan)
+{
+    State state = {plan.getlifeQualityScore(), plan.getEconomyScore(), plan.getEnvironmentScore(), plan.getFacilitiesCount(), plan.getUnderConstructionCount()};
+    return state;
+}
+
+void SettlementAggregates::add(int settlement, const State &state, int times)
+{
+    Totals &total = totalsOf(settlement);
+    total.lifeQualityScore += static_cast<long long>(state.life) * times;
+    total.economyScore += static_cast<long long>(state.eco) * times;
+    total.environmentScore += static_cast<long long>(state.env) * times;
+    total.operational += static_cast<long long>(state.operational) * times;
+    total.underConstruction += static_cast<long long>(state.underConstruction) * times;
+}
@@ -4,13 +4,26 @@
 #include "Facility.h"
 #include "Settlement.h"
 #include "Auxiliary.h"
+#include "Stats.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "StepCondition.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <limits>
 
 using namespace std;
 
-Simulation::Simulation(const string &configFilePath) : isRunning(false), planCounter(0), actionsLog(), plans(), settlements(), facilitiesOptions()
+thread_local Simulation *backup = nullptr; // one per thread, so batch runs don't share it
+
+Simulation::Simulation() : isRunning(false), output(&cout), planCounter(0), tick(0), generation(0), lazy(false), observers(), actionsLog(), plans(), representatives(), syncedTicks(), planTicks(), freshPlans(), settlements(), facilitiesOptions(), completedFacilities(), reportedCursors(), leaderboard(), settlementTotals(), changedPlans(), until(nullptr)
+{
+}
+
+Simulation::Simulation(const string &configFilePath) : isRunning(false), output(&cout), planCounter(0), tick(0), generation(0), lazy(false), observers(), actionsLog(), plans(), representatives(), syncedTicks(), planTicks(), freshPlans(), settlements(), facilitiesOptions(), completedFacilities(), reportedCursors(), leaderboard(), settlementTotals(), changedPlans(), until(nullptr)
 { // Initialize other members as needed
     std::ifstream configFile(configFilePath);
 
@@ -74,8 +87,20 @@ Simulation::Simulation(const string &configFilePath) : isRunning(false), planCou
                     break;
                 }
             }
-            plans.push_back(Plan(planCounter, *targetSettlement, policy, facilitiesOptions));
-            planCounter++;
+            addPlan(*targetSettlement, policy);
+        }
+        else if (parsedArgs[0] == "plans")
+        {
+            // plans <settlement|*> <policy> <count>, policies as for plan
+            const string policies[] = {"nve", "bal", "eco", "env"};
+            int policy = std::find(policies, policies + 4, parsedArgs[2]) - policies;
+            int count = std::stoi(parsedArgs[3]);
+            if (bulkPlanCount(parsedArgs[1], count) < 0)
+            {
+                *output << "Cannot create this plan" << endl;
+                continue;
+            }
+            addPlans(parsedArgs[1], static_cast<SelectionPolicyKind>(policy % 4), count);
         }
     }
     configFile.close();
@@ -87,93 +112,407 @@ void Simulation::start()
     cout << "The simulation has started" << endl;
     while (isRunning)
     {
-        BaseAction *action;
         string command;
         getline(cin, command);
-        vector<string> arguments = Auxiliary::parseArguments(command);
-        const string &requestedAction = arguments[0];
-        // checking commands
-        if (requestedAction == "plan")
+        BaseAction *action = parseAction(command);
+        if (action == nullptr)
+        {
+            cout << "Command not found" << endl;
+            continue;
+        }
+        execute(action);
+    }
+}
+
+// the action a command's words ask for, nullptr if they are not a command; a word that should be
+// a number and is not throws std::invalid_argument or std::out_of_range (from std::stoi)
+static BaseAction *buildAction(const vector<string> &arguments)
+{
+    BaseAction *action = nullptr;
+    const string &requestedAction = arguments[0];
+    // checking commands
+    if (requestedAction == "plan" && arguments.size() > 2)
+    {
+        const string &settlementName = arguments[1];
+        const string &selectionPolicy = arguments[2];
+        action = new AddPlan(settlementName, selectionPolicy);
+    }
+    else if (requestedAction == "step" && arguments.size() > 1)
+    {
+        action = new SimulateStep(std::stoi(arguments[1]));
+    }
+    else if (requestedAction == "settlement" && arguments.size() > 2)
+    {
+        const string &settlementName = arguments[1];
+        switch (std::stoi(arguments[2]))
         {
-            const string &settlementName = arguments[1];
-            const string &selectionPolicy = arguments[2];
-            action = new AddPlan(settlementName, selectionPolicy);
+        case 0:
+            action = new AddSettlement(settlementName, SettlementType::VILLAGE);
+            break;
+        case 1:
+            action = new AddSettlement(settlementName, SettlementType::CITY);
+            break;
+        case 2:
+            action = new AddSettlement(settlementName, SettlementType::METROPOLIS);
+            break;
+        default:
+            break; // no such settlement type
         }
-        else if (requestedAction == "step")
+    }
+    else if (requestedAction == "facility" && arguments.size() > 6)
+    {
+        string facilityName = arguments[1];
+        int categoryInt = std::stoi(arguments[2]); // Convert string to integer
+        FacilityCategory category = static_cast<FacilityCategory>(categoryInt);
+        int price = std::stoi(arguments[3]);
+        int lifeQualityScore = std::stoi(arguments[4]);
+        int economyScore = std::stoi(arguments[5]);
+        int environmentScore = std::stoi(arguments[6]);
+        action = new AddFacility(facilityName, category, price, lifeQualityScore, economyScore, environmentScore);
+    }
+    else if (requestedAction == "planStatus" && arguments.size() == 3 && arguments[1] == "all" && arguments[2] == "--changed")
+    {
+        action = new PrintChangedPlans();
+    }
+    else if (requestedAction == "planStatus" && arguments.size() == 4 && arguments[2] == "--since")
+    {
+        action = new PrintPlanChanges(std::stoi(arguments[1]), arguments[3]);
+    }
+    else if (requestedAction == "planStatus" && arguments.size() > 1)
+    {
+        action = new PrintPlanStatus(std::stoi(arguments[1]));
+    }
+    else if (requestedAction == "changePolicy" && arguments.size() > 2)
+    {
+        ChangePlanPolicy *change = new ChangePlanPolicy(std::stoi(arguments[1]), arguments[2]);
+        action = change;
+    }
+    else if (requestedAction == "compare" && arguments.size() > 2)
+    {
+        action = new ComparePolicies(std::stoi(arguments[1]), std::stoi(arguments[2]));
+    }
+    else if (requestedAction == "log")
+    {
+        action = new PrintActionsLog();
+    }
+    else if (requestedAction == "close")
+    {
+        action = new Close();
+    }
+    else if (requestedAction == "backup")
+    {
+        action = new BackupSimulation();
+    }
+    else if (requestedAction == "restore")
+    {
+        action = new RestoreSimulation();
+    }
+    else if (requestedAction == "stats")
+    {
+        action = new PrintStats(arguments.size() > 1 && arguments[1] == "--json");
+    }
+    else if (requestedAction == "memory")
+    {
+        action = new PrintMemory();
+    }
+    else if (requestedAction == "top" && arguments.size() > 2)
+    {
+        action = new PrintTopPlans(arguments[1], std::stoi(arguments[2]));
+    }
+    else if (requestedAction == "export" && arguments.size() > 1)
+    {
+        action = new ExportPlans(arguments[1]);
+    }
+    else if (requestedAction == "settlementStatus" && arguments.size() > 1)
+    {
+        action = new PrintSettlementStatus(arguments[1]);
+    }
+    else if (requestedAction == "plans" && arguments.size() > 3)
+    {
+        action = new AddPlans(arguments[1], arguments[2], std::stoi(arguments[3]));
+    }
+    else if (requestedAction == "stepUntil" && arguments.size() > 2)
+    {
+        string condition = arguments[2];
+        for (size_t i = 3; i < arguments.size(); i++)
         {
-            action = new SimulateStep(std::stoi(arguments[1]));
+            condition += " " + arguments[i];
         }
-        else if (requestedAction == "settlement")
+        action = new StepUntil(std::stoi(arguments[1]), condition);
+    }
+    return action;
+}
+
+BaseAction *Simulation::parseAction(const string &command)
+{
+    Trace::Span span("parse");
+    vector<string> arguments = Auxiliary::parseArguments(command);
+    if (arguments.empty())
+    {
+        return nullptr;
+    }
+    try
+    {
+        return buildAction(arguments);
+    }
+    catch (const std::logic_error &e) // std::invalid_argument and std::out_of_range
+    {
+        return nullptr;
+    }
+}
+
+void Simulation::execute(BaseAction *action)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        Trace::Span span(Stats::actionName(*action));
+        action->act(*this);
+    }
+    Stats::recordAction(*action, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    actionsLog.push_back(action);
+}
+
+void Simulation::step()
+{
+    Trace::Span span("tick", "tick", tick + 1);
+    freshPlans.clear(); // plans added from now on start a tick later than the current ones
+    Stats::local().add(Stats::TICKS);
+    if (lazy && observers.empty())
+    {
+        tick++;
+        return;
+    }
+
+    catchUpAll();
+    tick++;
+    PlanWorld world = steppingWorld();
+    if (observers.empty())
+    {
+        for (int i = 0; i < planCounter; i++)
         {
-            const string &settlementName = arguments[1];
-            switch (std::stoi(arguments[2]))
+            if (representatives[i] == i)
             {
-            case 0:
-                action = new AddSettlement(settlementName, SettlementType::VILLAGE);
-                break;
-            case 1:
-                action = new AddSettlement(settlementName, SettlementType::CITY);
-                break;
-            case 2:
-                action = new AddSettlement(settlementName, SettlementType::METROPOLIS);
-                break;
-            default:
-                throw std::runtime_error("Settlement not found");
+                plans[i].step(world);
+                planTicks[i] = tick;
             }
         }
-        else if (requestedAction == "facility")
+        updateIndexes();
+        return;
+    }
+
+    // a simulated plan's events sit together, from eventStart[i] to eventStart[i + 1], and stand for its mirrors too
+    vector<bool> changed(planCounter, false);
+    vector<PlanEvent> events;
+    vector<int> eventStart(planCounter + 1, 0);
+    world.events = &events;
+    for (int i = 0; i < planCounter; i++)
+    {
+        eventStart[i] = events.size();
+        if (representatives[i] != i)
         {
-            string facilityName = arguments[1];
-            int categoryInt = std::stoi(arguments[2]); // Convert string to integer
-            FacilityCategory category = static_cast<FacilityCategory>(categoryInt);
-            int price = std::stoi(arguments[3]);
-            int lifeQualityScore = std::stoi(arguments[4]);
-            int economyScore = std::stoi(arguments[5]);
-            int environmentScore = std::stoi(arguments[6]);
-            action = new AddFacility(facilityName, category, price, lifeQualityScore, economyScore, environmentScore);
+            continue;
         }
-        else if (requestedAction == "planStatus")
+        Plan &plan = plans[i];
+        int life = plan.getlifeQualityScore();
+        int eco = plan.getEconomyScore();
+        int env = plan.getEnvironmentScore();
+        plan.step(world);
+        planTicks[i] = tick;
+        changed[i] = life != plan.getlifeQualityScore() || eco != plan.getEconomyScore() || env != plan.getEnvironmentScore();
+    }
+    eventStart[planCounter] = events.size();
+    updateIndexes();
+    for (int i = 0; i < planCounter; i++)
+    {
+        if (changed[representatives[i]])
         {
-            action = new PrintPlanStatus(std::stoi(arguments[1]));
+            syncPlan(i);
+            for (StepObserver *observer : observers)
+            {
+                observer->onPlanChanged(tick, plans[i]);
+            }
         }
-        else if (requestedAction == "changePolicy")
+    }
+    for (int i = 0; i < planCounter && !events.empty(); i++)
+    {
+        int representative = representatives[i];
+        for (int e = eventStart[representative]; e < eventStart[representative + 1]; e++)
         {
-            ChangePlanPolicy *change = new ChangePlanPolicy(std::stoi(arguments[1]), arguments[2]);
-            action = change;
+            PlanEvent event = events[e];
+            event.tick = tick;
+            event.planId = plans[i].getID();
+            for (StepObserver *observer : observers)
+            {
+                observer->onPlanEvent(event);
+            }
         }
-        else if (requestedAction == "log")
+    }
+    for (StepObserver *observer : observers)
+    {
+        observer->onTickEnd(tick);
+    }
+}
+
+// Plans never read each other, so a multi-tick step can run plan-major: a block of plans small enough
+// to stay in cache goes through all the ticks before the next block is touched.
+static const int STEP_BLOCK_PLANS = 256;
+
+void Simulation::step(int numOfSteps)
+{
+    if (numOfSteps <= 0)
+    {
+        return;
+    }
+    if (lazy || !observers.empty() || numOfSteps == 1)
+    {
+        // lazy steps are free anyway, and observers expect to hear about the ticks in order
+        for (int i = 0; i < numOfSteps; i++)
         {
-            action = new PrintActionsLog();
+            step();
         }
-        else if (requestedAction == "close")
+        return;
+    }
+
+    Trace::Span span("ticks", "count", numOfSteps);
+    freshPlans.clear();
+    catchUpAll();
+    Stats::local().add(Stats::TICKS, numOfSteps);
+    PlanWorld world = steppingWorld();
+    for (int blockStart = 0; blockStart < planCounter; blockStart += STEP_BLOCK_PLANS)
+    {
+        int blockEnd = std::min(blockStart + STEP_BLOCK_PLANS, planCounter);
+#ifdef __GNUC__
+        for (int i = blockEnd; i < std::min(blockEnd + STEP_BLOCK_PLANS, planCounter); i++)
         {
-            action = new Close();
+            __builtin_prefetch(&plans[i]);
         }
-        else if (requestedAction == "backup")
+#endif
+        for (int t = 0; t < numOfSteps; t++)
         {
-            action = new BackupSimulation();
+            for (int i = blockStart; i < blockEnd; i++)
+            {
+                if (representatives[i] == i)
+                {
+                    plans[i].step(world);
+                }
+            }
         }
-        else if (requestedAction == "restore")
+    }
+
+    tick += numOfSteps;
+    for (int i = 0; i < planCounter; i++)
+    {
+        if (representatives[i] == i)
         {
-            action = new RestoreSimulation();
+            planTicks[i] = tick;
         }
-        else
+    }
+    updateIndexes();
+}
+
+bool Simulation::stepUntil(int maxSteps, StepCondition &condition)
+{
+    Trace::Span span("until", "max", maxSteps);
+    int steps = 0;
+    if (condition.getScope() == StepCondition::ONE_PLAN && observers.empty())
+    {
+        // only the watched plan has to go tick by tick, everything else catches up in one go afterwards
+        int representative = representatives[planIndex(condition.getPlanId())];
+        catchUp(representative);
+        condition.reset(representative);
+        condition.update(representative, plans[representative]);
+        until = &condition;
+        for (; steps < maxSteps && !condition.holds(); steps++)
         {
-            cout << "Command not found" << endl;
-            continue;
+            freshPlans.clear();
+            tick++;
+            catchUp(representative);
+        }
+        until = nullptr;
+        Stats::local().add(Stats::TICKS, steps);
+        if (!lazy)
+        {
+            catchUpAll();
         }
+        return condition.holds();
+    }
 
-        action->act(*this);
-        actionsLog.push_back(action);
+    int watched = condition.getScope() == StepCondition::ONE_PLAN ? representatives[planIndex(condition.getPlanId())] : -1;
+    catchUpAll();
+    condition.reset(watched);
+    for (int i = 0; i < planCounter; i++)
+    {
+        if (representatives[i] == i)
+        {
+            condition.update(i, plans[i]);
+        }
+    }
+    until = &condition;
+    for (; steps < maxSteps && !condition.holds(); steps++)
+    {
+        step();
+        if (lazy)
+        {
+            catchUpAll(); // the condition needs every plan's new state
+        }
     }
+    until = nullptr;
+    return condition.holds();
 }
 
-void Simulation::step()
+int Simulation::getTick() const
 {
-    for (int i = 0; i < planCounter; i++)
+    return tick;
+}
+
+void Simulation::setLazy(bool isLazy)
+{
+    if (!isLazy)
+    {
+        catchUpAll();
+    }
+    lazy = isLazy;
+}
+
+void Simulation::addObserver(StepObserver *observer)
+{
+    observers.push_back(observer);
+}
+
+void Simulation::removeObserver(StepObserver *observer)
+{
+    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+int Simulation::getPlanCount() const
+{
+    return planCounter;
+}
+
+const Plan &Simulation::planAt(int index)
+{
+    syncPlan(index);
+    return plans[index];
+}
+
+PlanRange Simulation::planStates()
+{
+    return PlanRange(*this);
+}
+
+int Simulation::getGeneration() const
+{
+    return generation;
+}
+
+PlanCursor &Simulation::reportedCursor(int index)
+{
+    if (index >= static_cast<int>(reportedCursors.size()))
     {
-        plans[i].step();
+        PlanCursor nothing = {-1, 0, 0};
+        reportedCursors.resize(planCounter, nothing);
     }
+    return reportedCursors[index];
 }
 
 void Simulation::close()
@@ -196,17 +535,112 @@ void Simulation::SetIsRunning(bool isRun)
     isRunning = isRun;
 }
 
-vector<Plan> Simulation::getPlans()
+bool Simulation::getIsRunning() const
+{
+    return isRunning;
+}
+
+std::ostream &Simulation::getOutput()
+{
+    return *output;
+}
+
+void Simulation::setOutput(std::ostream &newOutput)
+{
+    output = &newOutput;
+}
+
+PlanWorld Simulation::getWorld()
+{
+    PlanWorld world = {&settlements, &facilitiesOptions, &completedFacilities, &Stats::local(), nullptr, nullptr};
+    return world;
+}
+
+long long Simulation::memoryFootprint() const
 {
-    return plans;
+    long long bytes = plans.memoryBytes() + completedFacilities.memoryBytes();
+    bytes += static_cast<long long>(representatives.size() + syncedTicks.size() + planTicks.size()) * sizeof(int);
+    bytes += static_cast<long long>(settlements.size()) * (sizeof(Settlement) + sizeof(Settlement *));
+    bytes += static_cast<long long>(actionsLog.size()) * (Memory::averageObjectBytes(Memory::ACTIONS) + sizeof(BaseAction *));
+    return bytes;
+}
+
+long long Simulation::planFootprint(long long count)
+{
+    // the plan and its representative, sync and step ticks
+    return count * static_cast<long long>(sizeof(Plan) + 3 * sizeof(int));
 }
 
 void Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy)
 {
-    int planID = planCounter;
+    int settlementIndex = std::find(settlements.begin(), settlements.end(), &getSettlement(settlement.getName())) - settlements.begin();
+    appendPlan(Plan(planCounter, settlementIndex, settlement, selectionPolicy));
+}
+
+void Simulation::addPlans(const string &settlementName, SelectionPolicyKind policy, int count)
+{
+    int first = 0;
+    int last = settlements.size();
+    if (settlementName != "*")
+    {
+        first = std::find(settlements.begin(), settlements.end(), &getSettlement(settlementName)) - settlements.begin();
+        last = first + 1;
+    }
+    int total = static_cast<int>(planCounter + bulkPlanCount(settlementName, count)); // callers check it fits
+    plans.reserve(total);
+    representatives.reserve(total);
+    syncedTicks.reserve(total);
+    planTicks.reserve(total);
+    for (int settlementIndex = first; settlementIndex < last; settlementIndex++)
+    {
+        const Settlement &settlement = *settlements[settlementIndex];
+        for (int i = 0; i < count; i++)
+        {
+            appendPlan(Plan(planCounter, settlementIndex, settlement, policy));
+        }
+    }
+}
+
+// unknown settlements, negative counts and more plans than plan ids can number give -1
+long long Simulation::bulkPlanCount(const string &settlementName, int count)
+{
+    if (count < 0 || (settlementName != "*" && !isSettlementExists(settlementName)))
+    {
+        return -1;
+    }
+    long long created = static_cast<long long>(count) * (settlementName == "*" ? settlements.size() : 1);
+    return planCounter + created > std::numeric_limits<int>::max() ? -1 : created;
+}
+
+void Simulation::appendPlan(const Plan &plan)
+{
     planCounter++;
-    Plan p = Plan(planID, settlement, selectionPolicy, facilitiesOptions);
-    plans.push_back(p);
+    // a new plan only depends on its settlement's capacity and its policy until it first steps
+    int settlementIndex = plan.getSettlementIndex();
+    string state = to_string(settlements[settlementIndex]->facilitiesNum()) + " " + to_string(static_cast<int>(plan.getPolicyKind()));
+    plans.push_back(plan);
+
+    int index = plans.size() - 1;
+    auto fresh = freshPlans.find(state);
+    if (fresh == freshPlans.end())
+    {
+        freshPlans[state] = index;
+        representatives.push_back(index);
+    }
+    else
+    {
+        representatives.push_back(fresh->second);
+    }
+    syncedTicks.push_back(tick);
+    planTicks.push_back(tick);
+    if (leaderboard)
+    {
+        leaderboard->addPlan(index, representatives[index], plans[representatives[index]]);
+    }
+    if (settlementTotals)
+    {
+        settlementTotals->addPlan(index, representatives[index], settlementIndex, plans[representatives[index]]);
+    }
 }
 void Simulation::addAction(BaseAction *action)
 {
@@ -227,17 +661,29 @@ bool Simulation::addSettlement(Settlement *settlement)
 
 bool Simulation::addFacility(FacilityType facility)
 {
-    for (const FacilityType &f : facilitiesOptions)
+    for (int i = 0; i < facilitiesOptions.size(); i++)
     {
-        if (f.getName() == facility.getName())
+        if (facilitiesOptions.getName(i) == facility.getName())
         {
             return false;
         }
     }
+    // lagging plans must make their remaining selections from the catalog they would have seen
+    catchUpAll();
     facilitiesOptions.push_back(facility);
     return true;
 }
 
+FacilityCatalog Simulation::getCatalog() const
+{
+    return facilitiesOptions;
+}
+
+void Simulation::setCatalog(const FacilityCatalog &catalog)
+{
+    facilitiesOptions = catalog; // plans refer to facilities by index, nothing to rebind
+}
+
 bool Simulation::isSettlementExists(const string &settlementName)
 {
     for (const auto &settlement : settlements)
@@ -260,18 +706,197 @@ Settlement &Simulation::getSettlement(const string &settlementName)
     }
     throw std::runtime_error("Settlement not found");
 }
-Plan &Simulation::getPlan(const int planID)
+int Simulation::planIndex(const int planID) const
 {
-    for (auto &plan : plans)
+    if (planID >= 0 && planID < static_cast<int>(plans.size()) && plans[planID].getID() == planID)
+    {
+        return planID;
+    }
+    for (int i = 0; i < static_cast<int>(plans.size()); i++)
     {
-        if (plan.getID() == planID)
+        if (plans[i].getID() == planID)
         {
-            return plan;
+            return i;
         }
     }
     throw std::runtime_error("Plan not found");
 }
 
+Plan &Simulation::getPlan(const int planID)
+{
+    int index = planIndex(planID);
+    detachPlan(index);
+    return plans[index];
+}
+
+const Plan &Simulation::readPlan(const int planID)
+{
+    int index = planIndex(planID);
+    syncPlan(index);
+    return plans[index];
+}
+
+// steps a simulated plan through the ticks it skipped while nobody looked at it
+void Simulation::catchUp(int index)
+{
+    Plan &plan = plans[index];
+    PlanWorld world = steppingWorld();
+    for (int t = planTicks[index]; t < tick; t++)
+    {
+        plan.step(world);
+    }
+    planTicks[index] = tick;
+    updateIndexes();
+}
+
+void Simulation::catchUpAll()
+{
+    for (int i = 0; i < planCounter; i++)
+    {
+        if (representatives[i] == i)
+        {
+            catchUp(i);
+        }
+    }
+}
+
+// brings a plan up to the current tick, through its representative if it mirrors one
+void Simulation::syncPlan(int index)
+{
+    int representative = representatives[index];
+    catchUp(representative);
+    if (representative != index && syncedTicks[index] != tick)
+    {
+        plans[index].mirror(plans[representative]);
+        syncedTicks[index] = tick;
+    }
+}
+
+// the plan is about to change on its own: stop sharing its state with others
+void Simulation::detachPlan(int index)
+{
+    freshPlans.clear();
+    syncPlan(index);
+    PlanWorld world = getWorld();
+    if (representatives[index] != index)
+    {
+        plans[index].copyFacilities(world, world);
+        if (leaderboard)
+        {
+            leaderboard->detach(index, representatives[index], plans[index]);
+        }
+        if (settlementTotals)
+        {
+            settlementTotals->detach(index, representatives[index], plans[index].getSettlementIndex(), plans[index]);
+        }
+        representatives[index] = index;
+        planTicks[index] = tick;
+        return;
+    }
+
+    // followers are always created after their representative, the first of them takes over
+    int successor = -1;
+    for (int i = index + 1; i < planCounter; i++)
+    {
+        if (representatives[i] != index)
+        {
+            continue;
+        }
+        if (successor == -1)
+        {
+            syncPlan(i);
+            plans[i].copyFacilities(world, world);
+            representatives[i] = i;
+            planTicks[i] = tick;
+            successor = i;
+        }
+        else
+        {
+            representatives[i] = successor;
+        }
+    }
+    if (leaderboard && successor != -1)
+    {
+        leaderboard->handOver(index, successor, plans[successor]);
+    }
+    if (settlementTotals && successor != -1)
+    {
+        settlementTotals->handOver(index, plans[index].getSettlementIndex(), successor);
+    }
+}
+
+PlanWorld Simulation::steppingWorld()
+{
+    PlanWorld world = getWorld();
+    if (leaderboard || settlementTotals || until != nullptr)
+    {
+        world.changed = &changedPlans;
+    }
+    return world;
+}
+
+void Simulation::updateIndexes()
+{
+    for (int id : changedPlans.list())
+    {
+        int index = planIndex(id);
+        if (leaderboard)
+        {
+            leaderboard->setScores(index, plans[index]);
+        }
+        if (settlementTotals)
+        {
+            settlementTotals->update(index, plans[index]);
+        }
+        if (until != nullptr)
+        {
+            until->update(index, plans[index]);
+        }
+    }
+    changedPlans.clear();
+}
+
+const Leaderboard &Simulation::getLeaderboard()
+{
+    if (lazy)
+    {
+        catchUpAll();
+    }
+    if (!leaderboard)
+    {
+        leaderboard.reset(new Leaderboard());
+        for (int i = 0; i < planCounter; i++)
+        {
+            leaderboard->addPlan(i, representatives[i], plans[representatives[i]]);
+        }
+    }
+    return *leaderboard;
+}
+
+// lagging plans are counted as they are, catching up moves the totals like any other step
+void Simulation::buildSettlementTotals()
+{
+    settlementTotals.reset(new SettlementAggregates());
+    for (int i = 0; i < planCounter; i++)
+    {
+        settlementTotals->addPlan(i, representatives[i], plans[i].getSettlementIndex(), plans[representatives[i]]);
+    }
+}
+
+const SettlementAggregates::Totals &Simulation::getSettlementTotals(const string &settlementName)
+{
+    if (lazy)
+    {
+        catchUpAll();
+    }
+    if (!settlementTotals)
+    {
+        buildSettlementTotals();
+    }
+    Settlement *settlement = &getSettlement(settlementName);
+    return settlementTotals->get(std::find(settlements.begin(), settlements.end(), settlement) - settlements.begin());
+}
+
 // //         // ____________Rule of 5 __________________
 // //         // ____________Rule of 5 __________________
 // //         // ____________Rule of 5 __________________
@@ -292,7 +917,16 @@ void Simulation::clear()
     settlements.clear();
 
     plans.clear();
-    facilitiesOptions.clear();
+    representatives.clear();
+    syncedTicks.clear();
+    planTicks.clear();
+    freshPlans.clear();
+    facilitiesOptions = FacilityCatalog();
+    completedFacilities.clear();
+    reportedCursors.clear();
+    leaderboard.reset();
+    settlementTotals.reset();
+    changedPlans.clear();
 }
 
 void Simulation::copy(const Simulation &other)
@@ -307,22 +941,35 @@ void Simulation::copy(const Simulation &other)
     {
         settlements.push_back(new Settlement(settel->getName(), settel->getType()));
     }
-    for (Plan p : other.plans)
-    {
-        this->plans.push_back(Plan(p));
-    }
-    for (FacilityType f : other.facilitiesOptions)
-    {
-        this->facilitiesOptions.push_back(FacilityType(f));
-    }
+    facilitiesOptions = other.facilitiesOptions;
+    completedFacilities = other.completedFacilities;
+    plans = other.plans; // settlements are copied in order, so the plans' settlement indices still hold
+    representatives = other.representatives;
+    syncedTicks = other.syncedTicks;
+    planTicks = other.planTicks;
 }
 
 Simulation::Simulation(const Simulation &other) : isRunning(other.isRunning),
+                                                  output(other.output),
                                                   planCounter(other.planCounter), // For assigning unique plan IDs
+                                                  tick(other.tick),
+                                                  generation(other.generation),
+                                                  lazy(other.lazy),
+                                                  observers(), // observers watch one simulation, a copy starts without any
                                                   actionsLog(),
-                                                  plans(),
+                                                  plans(other.plans),
+                                                  representatives(other.representatives),
+                                                  syncedTicks(other.syncedTicks),
+                                                  planTicks(other.planTicks),
+                                                  freshPlans(),
                                                   settlements(),
-                                                  facilitiesOptions()
+                                                  facilitiesOptions(other.facilitiesOptions),
+                                                  completedFacilities(other.completedFacilities),
+                                                  reportedCursors(), // what was reported is the reader's, a copy has not shown anything
+                                                  leaderboard(),
+                                                  settlementTotals(),
+                                                  changedPlans(),
+                                                  until(nullptr)
 {
     for (Settlement *settel : settlements)
     {
@@ -334,12 +981,6 @@ Simulation::Simulation(const Simulation &other) : isRunning(other.isRunning),
         settlements.push_back(new Settlement(*settel));
     }
 
-    for (Plan p : other.plans)
-    {
-        Plan pnew(p.getID(), this->getSettlement(p.getSettlement().getName()), p.getSelectionPolicy()->clone(), p.getStatus(), p.getFacilities(), p.getunderConstruction(), facilitiesOptions, p.getlifeQualityScore(), p.getEconomyScore(), p.getEnvironmentScore());
-        plans.push_back(pnew);
-    }
-
     for (BaseAction *action : actionsLog)
     {
         delete action;
@@ -349,19 +990,17 @@ Simulation::Simulation(const Simulation &other) : isRunning(other.isRunning),
     {
         actionsLog.push_back(action->clone()); // Cloning each action polymorphically
     }
-
-    for (FacilityType f : other.facilitiesOptions)
-    {
-        this->facilitiesOptions.push_back(FacilityType(f));
-    }
 }
 
 Simulation &Simulation::operator=(const Simulation &other)
 {
     if (this != &other)
     {
+        // output is deliberately kept: a restore must not redirect printing to wherever the backup was taken
         isRunning = other.isRunning;
         planCounter = other.planCounter;
+        tick = other.tick;
+        generation = std::max(generation, other.generation) + 1; // the plans rewind, what readers saw no longer holds
 
         for (Settlement *settel : settlements)
         {
@@ -373,13 +1012,19 @@ Simulation &Simulation::operator=(const Simulation &other)
         {
             settlements.push_back(new Settlement(*settel));
         }
-        plans.clear();
-
-        for (Plan p : other.plans)
+        plans = other.plans;
+        representatives = other.representatives;
+        syncedTicks = other.syncedTicks;
+        planTicks = other.planTicks; // lagging plans stay lagging, they catch up from the restored state
+        freshPlans.clear();
+        facilitiesOptions = other.facilitiesOptions;
+        completedFacilities = other.completedFacilities;
+        leaderboard.reset(); // rebuilt from the restored scores when next asked for
+        if (settlementTotals)
         {
-            Plan pnew(p.getID(), this->getSettlement(p.getSettlement().getName()), p.getSelectionPolicy()->clone(), p.getStatus(), p.getFacilities(), p.getunderConstruction(), facilitiesOptions, p.getlifeQualityScore(), p.getEconomyScore(), p.getEnvironmentScore());
-            plans.push_back(pnew);
+            buildSettlementTotals(); // from the restored plans, right away
         }
+        changedPlans.clear();
 
         for (BaseAction *action : actionsLog)
         {
@@ -391,12 +1036,6 @@ Simulation &Simulation::operator=(const Simulation &other)
         {
             actionsLog.push_back(action->clone()); // Cloning each action polymorphically
         }
-
-        facilitiesOptions.clear();
-        for (FacilityType f : other.facilitiesOptions)
-        {
-            this->facilitiesOptions.push_back(FacilityType(f));
-        }
     }
     return *this;
 }
@@ -407,11 +1046,26 @@ Simulation::~Simulation()
 }
 
 Simulation::Simulation(Simulation &&other) : isRunning(other.isRunning),
+                                             output(other.output),
                                              planCounter(other.planCounter),
+                                             tick(other.tick),
+                                             generation(other.generation),
+                                             lazy(other.lazy),
+                                             observers(other.observers),
                                              actionsLog(other.actionsLog),
-                                             plans(other.plans),
+                                             plans(std::move(other.plans)),
+                                             representatives(other.representatives),
+                                             syncedTicks(other.syncedTicks),
+                                             planTicks(other.planTicks),
+                                             freshPlans(other.freshPlans),
                                              settlements(other.settlements),
-                                             facilitiesOptions(other.facilitiesOptions)
+                                             facilitiesOptions(other.facilitiesOptions),
+                                             completedFacilities(std::move(other.completedFacilities)),
+                                             reportedCursors(std::move(other.reportedCursors)),
+                                             leaderboard(std::move(other.leaderboard)),
+                                             settlementTotals(std::move(other.settlementTotals)),
+                                             changedPlans(std::move(other.changedPlans)),
+                                             until(nullptr)
 {
     other.actionsLog.clear();
     other.settlements.clear();
@@ -427,7 +1081,21 @@ Simulation &Simulation::operator=(Simulation &&other)
         // copy fields
         isRunning = other.isRunning;
         planCounter = other.planCounter;
-        plans = other.plans;
+        tick = other.tick;
+        generation = other.generation;
+        lazy = other.lazy;
+        observers = other.observers;
+        plans = std::move(other.plans);
+        representatives = other.representatives;
+        syncedTicks = other.syncedTicks;
+        planTicks = other.planTicks;
+        freshPlans = other.freshPlans;
+        facilitiesOptions = other.facilitiesOptions;
+        completedFacilities = std::move(other.completedFacilities);
+        reportedCursors = std::move(other.reportedCursors);
+        leaderboard = std::move(other.leaderboard);
+        settlementTotals = std::move(other.settlementTotals);
+        changedPlans = std::move(other.changedPlans);
         actionsLog = other.actionsLog;
         settlements = other.settlements;
 
@@ -435,4 +1103,43 @@ Simulation &Simulation::operator=(Simulation &&other)
         other.settlements.clear();
     }
     return *this;
-}
\ No newline at end of file
+}
+// Plan iteration
+PlanIterator::PlanIterator(Simulation &simulation, int index) : simulation(&simulation), index(index)
+{
+}
+
+const Plan &PlanIterator::operator*() const
+{
+    return simulation->planAt(index);
+}
+
+const Plan *PlanIterator::operator->() const
+{
+    return &simulation->planAt(index);
+}
+
+PlanIterator &PlanIterator::operator++()
+{
+    index++;
+    return *this;
+}
+
+bool PlanIterator::operator!=(const PlanIterator &other) const
+{
+    return index != other.index || simulation != other.simulation;
+}
+
+PlanRange::PlanRange(Simulation &simulation) : simulation(&simulation)
+{
+}
+
+PlanIterator PlanRange::begin() const
+{
+    return PlanIterator(*simulation, 0);
+}
+
+PlanIterator PlanRange::end() const
+{
+    return PlanIterator(*simulation, simulation->getPlanCount());
+}
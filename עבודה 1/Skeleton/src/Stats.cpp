@@ -0,0 +1,219 @@
+#include "Stats.h"
+#include "Action.h"
+#include <mutex>
+#include <vector>
+#include <typeinfo>
+#include <algorithm>
+
+using namespace std;
+
+// the action kinds, in the order the stats list them
+static const char *const ACTION_NAMES[Stats::ACTION_KINDS] = {"settlement", "facility", "plan", "step", "planStatus", "changePolicy", "compare", "log", "close", "backup", "restore", "stats",
+                                                               "memory", "export", "top", "settlementStatus", "stepUntil", "plans", "planStatusSince", "planStatusChanged", "other"};
+static const int OTHER_ACTION = Stats::ACTION_KINDS - 1;
+static const char *const POLICY_NAMES[] = {"nve", "bal", "eco", "env"};
+
+static int actionKind(const BaseAction &action)
+{
+    const std::type_info &type = typeid(action);
+    const std::type_info *const types[] = {&typeid(AddSettlement), &typeid(AddFacility), &typeid(AddPlan), &typeid(SimulateStep), &typeid(PrintPlanStatus), &typeid(ChangePlanPolicy), &typeid(ComparePolicies), &typeid(PrintActionsLog), &typeid(Close), &typeid(BackupSimulation), &typeid(RestoreSimulation), &typeid(PrintStats),
+                                               &typeid(PrintMemory), &typeid(ExportPlans), &typeid(PrintTopPlans), &typeid(PrintSettlementStatus), &typeid(StepUntil), &typeid(AddPlans), &typeid(PrintPlanChanges), &typeid(PrintChangedPlans)};
+    static_assert(sizeof(types) / sizeof(types[0]) == OTHER_ACTION, "every action kind but other needs its type");
+    for (int i = 0; i < OTHER_ACTION; i++)
+    {
+        if (type == *types[i])
+        {
+            return i;
+        }
+    }
+    return OTHER_ACTION;
+}
+
+static std::mutex blocksLock;
+
+// blocks of the running threads, and the sums of those that have finished
+static std::vector<Stats::Block *> &liveBlocks()
+{
+    static std::vector<Stats::Block *> blocks;
+    return blocks;
+}
+
+static Stats::Block &retiredBlock()
+{
+    static Stats::Block retired;
+    return retired;
+}
+
+namespace
+{
+    struct LocalBlock
+    {
+        LocalBlock() : block()
+        {
+            std::lock_guard<std::mutex> lock(blocksLock);
+            liveBlocks().push_back(&block);
+        }
+        ~LocalBlock();
+        Stats::Block block;
+    };
+}
+
+Stats::Block::Block() : counters(), actionCounts(), actionNanos(), stepHistogram(), untilSample(1)
+{
+}
+
+void Stats::Block::recordStep(long long nanos)
+{
+    int bucket = nanos <= 1 ? 0 : std::min(HISTOGRAM_BUCKETS - 1, 63 - __builtin_clzll(nanos));
+    stepHistogram[bucket].store(stepHistogram[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Stats::Block::recordAction(int kind, long long nanos)
+{
+    actionCounts[kind].store(actionCounts[kind].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    actionNanos[kind].store(actionNanos[kind].load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+}
+
+void Stats::Block::foldInto(Block &total) const
+{
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        total.counters[i].fetch_add(counters[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    for (int i = 0; i < ACTION_KINDS; i++)
+    {
+        total.actionCounts[i].fetch_add(actionCounts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        total.actionNanos[i].fetch_add(actionNanos[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        total.stepHistogram[i].fetch_add(stepHistogram[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+LocalBlock::~LocalBlock()
+{
+    std::lock_guard<std::mutex> lock(blocksLock);
+    block.foldInto(retiredBlock());
+    std::vector<Stats::Block *> &blocks = liveBlocks();
+    blocks.erase(std::remove(blocks.begin(), blocks.end(), &block), blocks.end());
+}
+
+Stats::Block &Stats::local()
+{
+    thread_local LocalBlock holder;
+    return holder.block;
+}
+
+void Stats::recordAction(const BaseAction &action, long long nanos)
+{
+    local().recordAction(actionKind(action), nanos);
+}
+
+const char *Stats::actionName(const BaseAction &action)
+{
+    return ACTION_NAMES[actionKind(action)];
+}
+
+// totals: the counters, then action counts, action nanoseconds and the step histogram
+static const int TOTALS = Stats::COUNTER_COUNT + 2 * Stats::ACTION_KINDS + Stats::HISTOGRAM_BUCKETS;
+
+void Stats::sumInto(const Block &block, long long *totals)
+{
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        totals[i] += block.counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < ACTION_KINDS; i++)
+    {
+        totals[COUNTER_COUNT + i] += block.actionCounts[i].load(std::memory_order_relaxed);
+        totals[COUNTER_COUNT + ACTION_KINDS + i] += block.actionNanos[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        totals[COUNTER_COUNT + 2 * ACTION_KINDS + i] += block.stepHistogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+void Stats::print(std::ostream &out, bool json)
+{
+    long long totals[TOTALS] = {};
+    {
+        std::lock_guard<std::mutex> lock(blocksLock);
+        sumInto(retiredBlock(), totals);
+        for (Block *block : liveBlocks())
+        {
+            sumInto(*block, totals);
+        }
+    }
+    const long long *actionCounts = totals + COUNTER_COUNT;
+    const long long *actionNanos = actionCounts + ACTION_KINDS;
+    const long long *histogram = actionNanos + ACTION_KINDS;
+    long long selections = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        selections += totals[SELECTIONS + i];
+    }
+
+    if (json)
+    {
+        out << "{\"ticks\":" << totals[TICKS] << ",\"planSteps\":" << totals[PLAN_STEPS]
+            << ",\"facilitiesStarted\":" << totals[FACILITIES_STARTED] << ",\"facilitiesCompleted\":" << totals[FACILITIES_COMPLETED]
+            << ",\"selections\":{";
+        for (int i = 0; i < 4; i++)
+        {
+            out << (i ? "," : "") << "\"" << POLICY_NAMES[i] << "\":" << totals[SELECTIONS + i];
+        }
+        out << "},\"catalogScanned\":" << totals[CATALOG_SCANNED] << ",\"actions\":{";
+        bool first = true;
+        for (int i = 0; i < OTHER_ACTION + 1; i++)
+        {
+            if (actionCounts[i] == 0)
+            {
+                continue;
+            }
+            out << (first ? "" : ",") << "\"" << ACTION_NAMES[i] << "\":{\"count\":" << actionCounts[i] << ",\"nanos\":" << actionNanos[i] << "}";
+            first = false;
+        }
+        out << "},\"planStepSampleRate\":" << STEP_SAMPLE_RATE << ",\"planStepNanosHistogram\":[";
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+        {
+            out << (i ? "," : "") << histogram[i];
+        }
+        out << "]}" << endl;
+        return;
+    }
+
+    out << "Ticks: " << totals[TICKS] << endl;
+    out << "PlanSteps: " << totals[PLAN_STEPS] << endl;
+    out << "FacilitiesStarted: " << totals[FACILITIES_STARTED] << endl;
+    out << "FacilitiesCompleted: " << totals[FACILITIES_COMPLETED] << endl;
+    out << "Selections:";
+    for (int i = 0; i < 4; i++)
+    {
+        out << " " << POLICY_NAMES[i] << " " << totals[SELECTIONS + i];
+    }
+    out << endl;
+    out << "CatalogScanned: " << totals[CATALOG_SCANNED];
+    if (selections > 0)
+    {
+        out << " (" << static_cast<double>(totals[CATALOG_SCANNED]) / selections << " per selection)";
+    }
+    out << endl;
+    out << "Action Count TotalMicros" << endl;
+    for (int i = 0; i < OTHER_ACTION + 1; i++)
+    {
+        if (actionCounts[i] > 0)
+        {
+            out << ACTION_NAMES[i] << " " << actionCounts[i] << " " << actionNanos[i] / 1000 << endl;
+        }
+    }
+    out << "PlanStepNanos (1 in " << STEP_SAMPLE_RATE << " sampled)" << endl;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        if (histogram[i] > 0)
+        {
+            out << (1LL << i) << "-" << (1LL << (i + 1)) << " " << histogram[i] << endl;
+        }
+    }
+}
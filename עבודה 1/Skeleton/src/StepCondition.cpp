@@ -0,0 +1,167 @@
+#include "StepCondition.h"
+#include "Auxiliary.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+// a whole word of digits, possibly negative
+static bool readNumber(const string &word, int &number)
+{
+    if (word.empty())
+    {
+        return false;
+    }
+    char *end = nullptr;
+    long parsed = std::strtol(word.c_str(), &end, 10);
+    number = static_cast<int>(parsed);
+    return *end == '\0';
+}
+
+StepCondition::StepCondition() : scope(ALL_PLANS), planId(-1), test(STATUS), comparison(EQUAL), value(0), status(PlanStatus::AVALIABLE), watched(-1), passing(), seen(0), passed(0)
+{
+}
+
+bool StepCondition::compile(const string &text)
+{
+    vector<string> words = Auxiliary::parseArguments(text);
+    size_t next = 2;
+    if (words.size() > 2 && words[0] == "plan" && readNumber(words[1], planId))
+    {
+        scope = ONE_PLAN;
+    }
+    else if (words.size() > 2 && words[0] == "any" && (words[1] == "plan" || words[1] == "plans"))
+    {
+        scope = ANY_PLAN;
+    }
+    else if (words.size() > 2 && words[0] == "all" && (words[1] == "plan" || words[1] == "plans"))
+    {
+        scope = ALL_PLANS;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (words.size() == next + 1)
+    {
+        test = STATUS;
+        if (words[next] == "AVALIABLE")
+        {
+            status = PlanStatus::AVALIABLE;
+            return true;
+        }
+        if (words[next] == "BUSY")
+        {
+            status = PlanStatus::BUSY;
+            return true;
+        }
+        return false;
+    }
+    if (words.size() != next + 3)
+    {
+        return false;
+    }
+    const string tests[] = {"life", "economy", "env", "balance"};
+    const string comparisons[] = {">=", ">", "<=", "<", "==", "!="};
+    int testIndex = std::find(tests, tests + STATUS, words[next]) - tests;
+    int comparisonIndex = std::find(comparisons, comparisons + 6, words[next + 1]) - comparisons;
+    if (testIndex == STATUS || comparisonIndex == 6 || !readNumber(words[next + 2], value))
+    {
+        return false;
+    }
+    test = static_cast<Test>(testIndex);
+    comparison = static_cast<Comparison>(comparisonIndex);
+    return true;
+}
+
+StepCondition::Scope StepCondition::getScope() const
+{
+    return scope;
+}
+
+int StepCondition::getPlanId() const
+{
+    return scope == ONE_PLAN ? planId : -1;
+}
+
+void StepCondition::reset(int watchedIndex)
+{
+    watched = watchedIndex;
+    passing.clear();
+    seen = 0;
+    passed = 0;
+}
+
+void StepCondition::update(int index, const Plan &plan)
+{
+    if (scope == ONE_PLAN && index != watched)
+    {
+        return;
+    }
+    if (index >= static_cast<int>(passing.size()))
+    {
+        passing.resize(index + 1, -1);
+    }
+    signed char now = passes(plan) ? 1 : 0;
+    if (passing[index] == -1)
+    {
+        seen++;
+    }
+    else
+    {
+        passed -= passing[index];
+    }
+    passed += now;
+    passing[index] = now;
+}
+
+bool StepCondition::holds() const
+{
+    // mirrors are in the state of the plan simulated for them, so the simulated plans decide
+    if (scope == ANY_PLAN)
+    {
+        return passed > 0;
+    }
+    return passed == seen && (scope == ALL_PLANS || seen == 1);
+}
+
+bool StepCondition::passes(const Plan &plan) const
+{
+    int life = plan.getlifeQualityScore();
+    int eco = plan.getEconomyScore();
+    int env = plan.getEnvironmentScore();
+    int score;
+    switch (test)
+    {
+    case LIFE_QUALITY:
+        score = life;
+        break;
+    case ECONOMY:
+        score = eco;
+        break;
+    case ENVIRONMENT:
+        score = env;
+        break;
+    case BALANCE:
+        score = std::max(life, std::max(eco, env)) - std::min(life, std::min(eco, env));
+        break;
+    default:
+        return plan.getStatus() == status;
+    }
+    switch (comparison)
+    {
+    case AT_LEAST:
+        return score >= value;
+    case ABOVE:
+        return score > value;
+    case AT_MOST:
+        return score <= value;
+    case BELOW:
+        return score < value;
+    case EQUAL:
+        return score == value;
+    default:
+        return score != value;
+    }
+}
@@ -0,0 +1,198 @@
+#include "Trace.h"
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        const char *argName;
+        long long arg;
+        long long startNanos;
+        long long endNanos;
+    };
+
+    // Written by its thread only, read by the writer only: each side owns one end
+    struct Ring
+    {
+        static const unsigned CAPACITY = 8192;
+
+        explicit Ring(int thread) : events(), head(0), tail(0), dropped(0), thread(thread) {}
+        Event events[CAPACITY];
+        std::atomic<unsigned> head; // next slot the thread fills
+        std::atomic<unsigned> tail; // next slot the writer reads
+        std::atomic<long long> dropped;
+        const int thread;
+    };
+}
+
+std::atomic<bool> Trace::active(false);
+
+static std::chrono::steady_clock::time_point epoch;
+static std::mutex ringsLock;
+static std::vector<std::unique_ptr<Ring>> rings; // every one made, kept until the process ends
+static std::vector<Ring *> freeRings;           // rings of finished threads, for the next thread to trace
+
+namespace
+{
+    // Hands the thread's ring back when the thread ends. The writer still drains what is left in it,
+    // and the thread that takes it over shows up under the same tid, after it.
+    struct LocalRing
+    {
+        LocalRing() : ring(nullptr) {}
+        ~LocalRing()
+        {
+            if (ring != nullptr)
+            {
+                std::lock_guard<std::mutex> lock(ringsLock);
+                freeRings.push_back(ring);
+            }
+        }
+        LocalRing(const LocalRing &other) = delete;
+        LocalRing &operator=(const LocalRing &other) = delete;
+        Ring *ring;
+    };
+}
+
+static thread_local LocalRing localRing;
+
+static std::mutex writerLock;
+static std::condition_variable writerWake;
+static bool stopping = false;
+static std::thread writer;
+static std::ofstream file;
+static bool firstEvent = true;
+
+static const std::chrono::milliseconds FLUSH_INTERVAL(20);
+
+static void writeEvent(const Event &event, int thread)
+{
+    file << (firstEvent ? "\n" : ",\n");
+    firstEvent = false;
+    file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+         << ",\"ts\":" << event.startNanos / 1000 << "." << event.startNanos / 100 % 10 << event.startNanos / 10 % 10 << event.startNanos % 10;
+    long long duration = event.endNanos - event.startNanos;
+    file << ",\"dur\":" << duration / 1000 << "." << duration / 100 % 10 << duration / 10 % 10 << duration % 10;
+    if (event.argName != nullptr)
+    {
+        file << ",\"args\":{\"" << event.argName << "\":" << event.arg << "}";
+    }
+    file << "}";
+}
+
+static void drain()
+{
+    std::vector<Ring *> current;
+    {
+        std::lock_guard<std::mutex> lock(ringsLock);
+        for (const std::unique_ptr<Ring> &ring : rings)
+        {
+            current.push_back(ring.get());
+        }
+    }
+    for (Ring *ring : current)
+    {
+        unsigned tail = ring->tail.load(std::memory_order_relaxed);
+        unsigned head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++)
+        {
+            writeEvent(ring->events[tail % Ring::CAPACITY], ring->thread);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    file.flush();
+}
+
+static void writeLoop()
+{
+    std::unique_lock<std::mutex> lock(writerLock);
+    while (!stopping)
+    {
+        writerWake.wait_for(lock, FLUSH_INTERVAL);
+        drain();
+    }
+}
+
+bool Trace::start(const string &path)
+{
+    file.open(path);
+    if (!file)
+    {
+        return false;
+    }
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    epoch = std::chrono::steady_clock::now();
+    stopping = false;
+    writer = std::thread(writeLoop);
+    active.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void Trace::stop()
+{
+    if (!active.exchange(false, std::memory_order_relaxed))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(writerLock);
+        stopping = true;
+    }
+    writerWake.notify_one();
+    writer.join();
+    drain();
+
+    long long dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(ringsLock);
+        for (const std::unique_ptr<Ring> &ring : rings)
+        {
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    file << (firstEvent ? "" : ",") << "\n{\"name\":\"dropped spans\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":0,\"args\":{\"count\":" << dropped << "}}";
+    file << "\n]}\n";
+    file.close();
+}
+
+long long Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::record(const char *name, const char *argName, long long arg, long long startNanos, long long endNanos)
+{
+    if (localRing.ring == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(ringsLock);
+        if (freeRings.empty())
+        {
+            rings.push_back(std::unique_ptr<Ring>(new Ring(rings.size() + 1)));
+            freeRings.push_back(rings.back().get());
+        }
+        localRing.ring = freeRings.back();
+        freeRings.pop_back();
+    }
+    Ring &ring = *localRing.ring;
+    unsigned head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == Ring::CAPACITY)
+    {
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    Event &event = ring.events[head % Ring::CAPACITY];
+    event.name = name;
+    event.argName = argName;
+    event.arg = arg;
+    event.startNanos = startNanos;
+    event.endNanos = endNanos;
+    ring.head.store(head + 1, std::memory_order_release);
+}
@@ -0,0 +1,128 @@
+#include "WorldGenerator.h"
+
+using namespace std;
+
+WorldGenerator::Options::Options() : settlements(100), facilities(64), lifeQualityWeight(1), economyWeight(1), environmentWeight(1), plans(10000), seed(1)
+{
+}
+
+WorldGenerator::WorldGenerator(const Options &options) : options(options), state(options.seed == 0 ? 1 : options.seed)
+{
+}
+
+// xorshift32: small, fast, and the same everywhere (unlike the std distributions)
+unsigned WorldGenerator::next()
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int WorldGenerator::nextInt(int bound)
+{
+    return static_cast<int>(next() % static_cast<unsigned>(bound));
+}
+
+string WorldGenerator::settlementName(int index)
+{
+    return "settlement" + to_string(index);
+}
+
+string WorldGenerator::facilityName(int index)
+{
+    return "facility" + to_string(index);
+}
+
+const char *WorldGenerator::policyName(int index)
+{
+    static const char *const policies[] = {"nve", "bal", "eco", "env"};
+    return policies[index & 3];
+}
+
+void WorldGenerator::writeConfig(std::ostream &out)
+{
+    out << "# generated: seed " << options.seed << ", " << options.settlements << " settlements, " << options.facilities
+        << " facilities (" << options.lifeQualityWeight << ":" << options.economyWeight << ":" << options.environmentWeight << "), "
+        << options.plans << " plans\n";
+    for (int i = 0; i < options.settlements; i++)
+    {
+        out << "settlement " << settlementName(i) << " " << nextInt(3) << "\n";
+    }
+
+    int totalWeight = options.lifeQualityWeight + options.economyWeight + options.environmentWeight;
+    for (int i = 0; i < options.facilities; i++)
+    {
+        int category = i;
+        if (i >= 3)
+        {
+            int pick = totalWeight > 0 ? nextInt(totalWeight) : 0;
+            category = pick < options.lifeQualityWeight ? 0 : (pick < options.lifeQualityWeight + options.economyWeight ? 1 : 2);
+        }
+        out << "facility " << facilityName(i) << " " << category << " " << 1 + nextInt(6) << " "
+            << nextInt(6) << " " << nextInt(6) << " " << nextInt(6) << "\n";
+    }
+
+    for (int i = 0; i < options.plans && options.settlements > 0; i++)
+    {
+        out << "plan " << settlementName(nextInt(options.settlements)) << " " << policyName(nextInt(4)) << "\n";
+    }
+}
+
+// out of every 10000 commands
+static const int STEP_SHARE = 3000;
+static const int STATUS_SHARE = 5000;
+static const int PLAN_SHARE = 1000;
+static const int POLICY_SHARE = 900;
+static const int BACKUP_SHARE = 50;
+static const int RESTORE_SHARE = 49; // the remaining 1 is log
+
+void WorldGenerator::writeTrace(std::ostream &out, long long commands)
+{
+    // follow the plan count so every id the trace names exists when it runs
+    int planCount = options.settlements > 0 ? options.plans : 0;
+    int backupPlanCount = -1;
+    for (long long i = 0; i + 1 < commands; i++)
+    {
+        int pick = nextInt(10000);
+        if ((pick -= STEP_SHARE) < 0)
+        {
+            out << "step " << 1 + nextInt(3) << "\n";
+        }
+        else if ((pick -= STATUS_SHARE) < 0 && planCount > 0)
+        {
+            out << "planStatus " << nextInt(planCount) << "\n";
+        }
+        else if ((pick -= PLAN_SHARE) < 0 && options.settlements > 0)
+        {
+            out << "plan " << settlementName(nextInt(options.settlements)) << " " << policyName(nextInt(4)) << "\n";
+            planCount++;
+        }
+        else if ((pick -= POLICY_SHARE) < 0 && planCount > 0)
+        {
+            out << "changePolicy " << nextInt(planCount) << " " << policyName(nextInt(4)) << "\n";
+        }
+        else if ((pick -= BACKUP_SHARE) < 0)
+        {
+            out << "backup\n";
+            backupPlanCount = planCount;
+        }
+        else if ((pick -= RESTORE_SHARE) < 0 && backupPlanCount >= 0)
+        {
+            out << "restore\n";
+            planCount = backupPlanCount;
+        }
+        else if (pick >= 0)
+        {
+            out << "log\n";
+        }
+        else
+        {
+            out << "step 1\n";
+        }
+    }
+    if (commands > 0)
+    {
+        out << "close\n";
+    }
+}
@@ -1,24 +1,142 @@
 #include "Simulation.h"
+#include "Server.h"
+#include "BatchRunner.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "EventFeed.h"
+#include "PlanExport.h"
 #include <iostream>
+#include <thread>
+#include <climits>
+#include <cstdlib>
+#include <cerrno>
+#include <stdexcept>
 
 using namespace std;
 
-Simulation* backup = nullptr;
+extern thread_local Simulation* backup;
+
+static void usage(){
+    cout << "usage: simulation <config_path> [--lazy] [--listen <socket_path>] [--memory-limit <megabytes>] [--trace <trace_file>]" << endl;
+    cout << "                  [--events <fifo_or_file> [--events-format jsonl|binary]]" << endl;
+    cout << "       simulation --batch <configs_list> --script <commands_file> [--jobs <n>] [--out <results_file>] [--trace <trace_file>]" << endl;
+}
+
+// a whole word of digits from 0 to max, or false
+static bool readNumber(const char* text, long long max, long long& value){
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtoll(text, &end, 10);
+    return *text != '\0' && *end == '\0' && errno == 0 && value >= 0 && value <= max;
+}
+
+static bool startTrace(const string& path){
+    if(path.empty() || Trace::start(path)) return true;
+    cout << "Cannot open trace file " << path << endl;
+    return false;
+}
+
+// exports still being written when the run ends, and any that failed since the last export command
+static void finishExports(){
+    PlanExport::waitAll();
+    string failed;
+    while(PlanExport::takeFailure(failed)) cout << "Cannot write " << failed << endl;
+}
+
+static int runBatch(int argc, char** argv){
+    string configs, script, results, tracePath;
+    int jobs = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    for(int i = 1; i + 1 < argc; i += 2){
+        string option = argv[i];
+        if(option == "--batch") configs = argv[i + 1];
+        else if(option == "--script") script = argv[i + 1];
+        else if(option == "--jobs"){
+            long long count;
+            jobs = readNumber(argv[i + 1], INT_MAX, count) ? static_cast<int>(count) : 0; // 0 shows the usage below
+        }
+        else if(option == "--out") results = argv[i + 1];
+        else if(option == "--trace") tracePath = argv[i + 1];
+        else{
+            usage();
+            return 0;
+        }
+    }
+    if(configs.empty() || script.empty() || jobs < 1 || argc % 2 == 0){
+        usage();
+        return 0;
+    }
+    if(!startTrace(tracePath)) return 0;
+    try{
+        BatchRunner runner(configs, script, jobs, results);
+        runner.run();
+    }
+    catch(const std::runtime_error& e){
+        cout << e.what() << endl; // a list, script or results file that cannot be opened
+    }
+    finishExports();
+    Trace::stop();
+    return 0;
+}
 
 int main(int argc, char** argv){
-    if(argc!=2){
-        cout << "usage: simulation <config_path>" << endl;
+    if(argc > 1 && string(argv[1]) == "--batch"){
+        return runBatch(argc, argv);
+    }
+    if(argc < 2){
+        usage();
         return 0;
     }
+    bool lazy = false;
+    string socketPath, tracePath, eventsPath;
+    bool binaryEvents = false;
+    long long megabytes;
+    for(int i = 2; i < argc; i++){
+        string option = argv[i];
+        if(option == "--lazy") lazy = true;
+        else if(option == "--listen" && i + 1 < argc) socketPath = argv[++i];
+        else if(option == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if(option == "--events" && i + 1 < argc) eventsPath = argv[++i];
+        else if(option == "--events-format" && i + 1 < argc && (string(argv[i + 1]) == "jsonl" || string(argv[i + 1]) == "binary")) binaryEvents = string(argv[++i]) == "binary";
+        else if(option == "--memory-limit" && i + 1 < argc && readNumber(argv[++i], LLONG_MAX >> 20, megabytes)) Memory::setSoftLimit(megabytes << 20);
+        else{
+            usage();
+            return 0;
+        }
+    }
+    if(!startTrace(tracePath)) return 0;
     string configurationFile = argv[1];
     Simulation simulation(configurationFile);
-    simulation.start();
+    simulation.setLazy(lazy);
+    EventFeed* events = nullptr;
+    if(!eventsPath.empty()){
+        events = new EventFeed(eventsPath, binaryEvents);
+        if(!events->isOpen()){
+            cout << "Cannot open events file " << eventsPath << endl;
+            delete events;
+            return 0;
+        }
+        simulation.addObserver(events);
+    }
+    if(!socketPath.empty()){
+        Server server(simulation, socketPath);
+        server.run();
+    }
+    else{
+        simulation.start();
+    }
     if(backup!=nullptr){
     	delete backup;
     	backup = nullptr;
+    	Memory::setBackup(0);
+    }
+    if(events!=nullptr){
+        simulation.removeObserver(events);
+        delete events;
     }
+    finishExports();
+    Trace::stop();
 
     return 0;
 
 
-}
\ No newline at end of file
+}
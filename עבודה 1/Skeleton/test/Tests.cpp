@@ -0,0 +1,288 @@
+// Regression tests, run from the project directory against config_file.txt (make test).
+// Each test drives a simulation through its commands and checks what they print.
+#include "Simulation.h"
+#include "Action.h"
+#include "Memory.h"
+#include "Stats.h"
+#include "Trace.h"
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do                                                                            \
+    {                                                                             \
+        if (!(condition))                                                         \
+        {                                                                         \
+            std::printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+// runs the commands one by one and returns everything they printed
+static string run(Simulation &simulation, const vector<string> &commands)
+{
+    std::ostringstream out;
+    simulation.setOutput(out);
+    for (const string &command : commands)
+    {
+        BaseAction *action = Simulation::parseAction(command);
+        if (action != nullptr)
+        {
+            simulation.execute(action);
+        }
+    }
+    simulation.setOutput(std::cout);
+    return out.str();
+}
+
+static long peakKilobytes()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// a long step over 100 simulated plans, with the index the query builds kept up to date through it;
+// returns how far the step raised the peak, and checks the query's answer after it with verify
+static long longStepPeakGrowth(const string &query, const std::function<void(Simulation &, const string &)> &verify)
+{
+    Simulation simulation("config_file.txt");
+    vector<string> commands;
+    for (int i = 0; i < 100; i++)
+    {
+        // a tick apart, so no plan mirrors another and every one of them is simulated
+        commands.push_back(i % 2 == 0 ? "plan KiryatSPL eco" : "plan BeitSPL env");
+        commands.push_back("step 1");
+    }
+    if (!query.empty())
+    {
+        commands.push_back(query);
+    }
+    run(simulation, commands);
+
+    long before = peakKilobytes();
+    run(simulation, {"step 300000"});
+    long growth = peakKilobytes() - before;
+    if (!query.empty())
+    {
+        verify(simulation, run(simulation, {query}));
+    }
+    return growth;
+}
+
+// the finished facilities grow the same either way, so after a run with no index the peak only
+// moves by what the index costs (tests run in fresh processes, see main)
+static long indexPeakGrowth(const string &query, const std::function<void(Simulation &, const string &)> &verify)
+{
+    longStepPeakGrowth("", verify);
+    return longStepPeakGrowth(query, verify);
+}
+
+// plans changed over a long step are noted once each, not once per tick
+static void longStepWithLeaderboard()
+{
+    long growth = indexPeakGrowth("top life 1", [](Simulation &simulation, const string &top)
+    {
+        int best = -1;
+        for (const Plan &plan : simulation.planStates())
+        {
+            best = std::max(best, plan.getlifeQualityScore());
+        }
+        CHECK(top.find("LifeQualityScore: " + to_string(best) + " ") != string::npos);
+    });
+    CHECK(growth < 8 * 1024);
+
+    ChangedPlans changed;
+    for (int tick = 0; tick < 1000; tick++)
+    {
+        changed.note(3);
+        changed.note(tick % 2);
+    }
+    CHECK(changed.list().size() == 3);
+    changed.clear();
+    changed.note(3);
+    CHECK(changed.list().size() == 1);
+}
+
+// the settlement totals share the leaderboard's list of changed plans
+static void longStepWithSettlementTotals()
+{
+    long growth = indexPeakGrowth("settlementStatus KiryatSPL", [](Simulation &simulation, const string &status)
+    {
+        long long plans = 0, life = 0, operational = 0, underConstruction = 0;
+        for (const Plan &plan : simulation.planStates())
+        {
+            if (plan.getSettlement(simulation.getWorld()).getName() == "KiryatSPL")
+            {
+                plans++;
+                life += plan.getlifeQualityScore();
+                operational += plan.getFacilitiesCount();
+                underConstruction += plan.getUnderConstructionCount();
+            }
+        }
+        CHECK(status.find("Plans: " + to_string(plans) + "\n") != string::npos);
+        CHECK(status.find("LifeQualityScore: " + to_string(life) + " ") != string::npos);
+        CHECK(status.find("OperationalFacilities: " + to_string(operational) + "\n") != string::npos);
+        CHECK(status.find("FacilitiesUnderConstruction: " + to_string(underConstruction) + "\n") != string::npos);
+    });
+    CHECK(growth < 8 * 1024);
+}
+
+static int spread(const Plan &plan)
+{
+    int life = plan.getlifeQualityScore();
+    int eco = plan.getEconomyScore();
+    int env = plan.getEnvironmentScore();
+    return std::max(life, std::max(eco, env)) - std::min(life, std::min(eco, env));
+}
+
+// stepUntil stops on the first tick a plan's balance, the spread of its scores, reaches the threshold
+static void stepUntilBalance()
+{
+    // config_file.txt has plans 0 and 1, these are 2 to 4
+    const vector<string> world = {"plan KiryatSPL eco", "plan BeitSPL env", "step 1", "plan KfarSPL bal"};
+    const int threshold = 10;
+    Simulation reference("config_file.txt");
+    run(reference, world);
+    int expected = -1;
+    for (int t = 0; t < 200 && expected == -1; t++)
+    {
+        if (spread(reference.readPlan(2)) >= threshold)
+        {
+            expected = reference.getTick();
+        }
+        reference.step();
+    }
+    CHECK(expected > 1);
+
+    Simulation simulation("config_file.txt");
+    run(simulation, world);
+    string reached = run(simulation, {"stepUntil 200 plan 2 balance >= " + to_string(threshold)});
+    CHECK(reached == "Tick: " + to_string(expected) + " ConditionMet: true\n");
+    CHECK(spread(simulation.readPlan(2)) >= threshold);
+
+    // a spread is never negative, and a fresh plan's is 0
+    CHECK(run(simulation, {"stepUntil 5 all plans balance < 0"}) == "Tick: " + to_string(expected + 5) + " ConditionMet: false\n");
+    run(simulation, {"plan KfarSPL nve"});
+    CHECK(run(simulation, {"stepUntil 5 plan 5 balance <= 0"}) == "Tick: " + to_string(expected + 5) + " ConditionMet: true\n");
+}
+
+// commands from a client are untrusted: a missing or malformed argument is no command at all
+static void malformedCommands()
+{
+    const char *const commands[] = {"step", "plan", "plan KfarSPL", "changePolicy 3", "step abc", "step 99999999999",
+                                    "settlement x 7", "facility a 1 2", "compare 1", "planStatus", "planStatus x", "top life x"};
+    for (const char *command : commands)
+    {
+        CHECK(Simulation::parseAction(command) == nullptr);
+    }
+    // well formed, but no such policy
+    Simulation simulation("config_file.txt");
+    CHECK(run(simulation, {"changePolicy 0 foo", "changePolicy 0 env"}) ==
+          "Cannot change selection policy\nPlanID: 0\nPreviousPolicy: Economy\nnewPolicy: Sustainability\n");
+    BaseAction *step = Simulation::parseAction("step 3");
+    CHECK(step != nullptr);
+    delete step;
+}
+
+// a bulk add is checked as a whole: against the soft limit, and against how many ids plans can have
+static void bulkPlanLimits()
+{
+    Simulation simulation("config_file.txt");
+    Memory::setSoftLimit(8 << 20);
+    CHECK(run(simulation, {"plans * nve 1000000"}) == "Memory limit reached\n");
+    CHECK(run(simulation, {"plans * nve 2000000000", "plans KfarSPL nve 2147483647", "plans nowhere nve 1"}) ==
+          "Cannot create this plan\nCannot create this plan\nCannot create this plan\n");
+    CHECK(simulation.getPlanCount() == 2);
+    run(simulation, {"plans * eco 1000"});
+    CHECK(simulation.getPlanCount() == 3002);
+}
+
+// every command is counted, and traced, under a kind of its own rather than as other
+static void actionKinds()
+{
+    const vector<std::pair<string, string>> commands = {
+        {"memory", "memory"}, {"top life 2", "top"}, {"settlementStatus KfarSPL", "settlementStatus"},
+        {"stepUntil 2 any plan BUSY", "stepUntil"}, {"plans * eco 2", "plans"}, {"planStatus 0 --since 0", "planStatusSince"},
+        {"planStatus all --changed", "planStatusChanged"}, {"export /dev/null", "export"}};
+    for (const auto &command : commands)
+    {
+        BaseAction *action = Simulation::parseAction(command.first);
+        CHECK(action != nullptr && Stats::actionName(*action) == command.second);
+        delete action;
+    }
+}
+
+// the threads a compare starts trace into the rings of the compares before it
+static void traceRingsReused()
+{
+    Simulation simulation("config_file.txt");
+    CHECK(Trace::start("/dev/null"));
+    run(simulation, {"compare 0 1"});
+    long before = peakKilobytes();
+    run(simulation, vector<string>(50, "compare 0 1"));
+    CHECK(peakKilobytes() - before < 4 * 1024);
+    Trace::stop();
+}
+
+// a thread dropping its backup leaves the backups of other threads counted
+static void backupsPerThread()
+{
+    Memory::setBackup(1000);
+    std::thread worker([]()
+    {
+        Memory::setBackup(300);
+        CHECK(Memory::backupBytes() == 300);
+        Memory::setBackup(0);
+    });
+    worker.join();
+    CHECK(Memory::liveBytes(Memory::BACKUP) == 1000);
+    CHECK(Memory::backupBytes() == 1000);
+    Memory::setBackup(400);
+    CHECK(Memory::liveBytes(Memory::BACKUP) == 400);
+}
+
+int main()
+{
+    const std::pair<const char *, std::function<void()>> tests[] = {
+        {"long step with a leaderboard", longStepWithLeaderboard},
+        {"long step with settlement totals", longStepWithSettlementTotals},
+        {"stepUntil on a balance threshold", stepUntilBalance},
+        {"malformed commands", malformedCommands},
+        {"bulk plan limits", bulkPlanLimits},
+        {"action kinds", actionKinds},
+        {"trace rings reused", traceRingsReused},
+        {"backups per thread", backupsPerThread},
+    };
+    int failed = 0;
+    for (const auto &test : tests)
+    {
+        // each test in a process of its own, so peak memory and global counters start fresh
+        std::fflush(stdout);
+        pid_t child = fork();
+        if (child == 0)
+        {
+            test.second();
+            std::fflush(stdout);
+            _exit(failures == 0 ? 0 : 1);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        bool passed = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        failed += passed ? 0 : 1;
+        std::printf("%s %s\n", passed ? "ok  " : "FAIL", test.first);
+    }
+    return failed == 0 ? 0 : 1;
+}